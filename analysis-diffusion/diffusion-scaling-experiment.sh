@@ -17,39 +17,46 @@
 #
 # Questions/comments to Trevor Keller (trevor.keller@nist.gov)
 
-# This script will build and execute diffusion programs for CPU and GPU architectures
-# on a square mesh with edge length L=256 units, using the following set of mesh
-# resolutions: 256, 512, 768, 1024, 1280, 1536, 1792, & 2048 points per dimension.
-# The results are stored in the separate program directories, moved from `runlog.csv`
-# to `runlog_<edge>.csv. These are then used by plot_runtimes.py to create scaling
-# plots of runtime as a function of domain size (L×L) for each successful simulation.
+# This script builds the in-process benchmark harness (common-diffusion/benchmark.cpp)
+# for each CPU diffusion backend and sweeps square meshes with edge length L=256 units
+# at 256, 512, 768, 1024, 1280, 1536, 1792, & 2048 points per dimension, for each
+# stencil code, field layout, and thread count. Every case is warmed up, then timed
+# over repeated batches of steps, so that variance is reported alongside the median.
+# Results are written to benchmark-<backend>.csv and .json in this directory, then
+# plotted by plot_runtimes.py. The GPU backends manage device memory in their own
+# main programs and are not linked by the harness; time them with `make run`.
+#
+# Usage: ./diffusion-scaling-experiment.sh
+# Environment: SIZES, CODES, LAYOUTS, THREADS (comma-separated lists), WARMUP, REPS, STEPS
+
+SIZES=${SIZES:-256,512,768,1024,1280,1536,1792,2048}
+CODES=${CODES:-53,93,95}
+LAYOUTS=${LAYOUTS:-rows,tiles}
+THREADS=${THREADS:-$(seq -s, 1 $(nproc))}
+WARMUP=${WARMUP:-10}
+REPS=${REPS:-10}
+STEPS=${STEPS:-100}
 
 DATADIR=$(pwd)
-find . -name "runlog*csv" -exec rm {} \;
-cd `dirname "${DATADIR}"`
-cp -a common-diffusion/params.txt analysis-diffusion/params.bak
+ROOTDIR=$(dirname "${DATADIR}")
 
-for i in {1..8}
+for backend in serial openmp tbb
 do
-	NX=$(echo "print int(256*${i})" | python)
-	DX=$(echo "print 1.0/${i}"      | python)
-	DT=$(echo "print 0.1*${DX}*${DX}/(4.0*0.00625)" | python)
-	NC=$(echo "print int(100000.01/${DT})"          | python)
-	DC=$(echo "print int(${NC}/10)" | python)
-	sed "s/NXY/${NX}/g;s/dXY/${DX}/g;s/NC/${NC}/g;s/dT/${DC}/g" analysis-diffusion/params.in > common-diffusion/params.txt
-	echo "Running with domain size L=${NX}"
-	make run
-	for f in $(find . -name "runlog.csv")
-	do
-		tail -n 1 $f
-		mv $f ${f/runlog./scaling_${NX}.}
-	done
-	sleep 1
-	echo
-done
+	if ! make -C "${ROOTDIR}/cpu-${backend}-diffusion" benchmark
+	then
+		echo "Unable to build the ${backend} benchmark; skipping."
+		continue
+	fi
 
-mv analysis-diffusion/params.bak common-diffusion/params.txt
+	NT=${THREADS}
+	if [[ ${backend} == "serial" ]]
+	then
+		NT=1
+	fi
 
-cd $DATADIR
-python plot_runtimes.py
+	"${ROOTDIR}/cpu-${backend}-diffusion/benchmark" -n ${SIZES} -s ${CODES} -l ${LAYOUTS} \
+		-t ${NT} -w ${WARMUP} -r ${REPS} -k ${STEPS} -o "${DATADIR}/benchmark-${backend}"
+	echo
+done
 
+python3 plot_runtimes.py
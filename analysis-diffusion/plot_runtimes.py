@@ -18,151 +18,211 @@
 # ***********************************************************************************
 
 # Usage: python plot_runtimes.py
+#
+# Plots benchmark-<backend>.csv, written by the in-process benchmark harness
+# (see diffusion-scaling-experiment.sh), and any legacy runlogs named
+# ../<backend>/scaling_<nx>.csv.
 
+import csv
 import glob
 import numpy as np
 from sys import argv
 from os import path
 import matplotlib.pylab as plt
 
-cpuBase = ("serial", "openmp", "tbb")
-gpuBase = ("cuda", "openacc", "opencl")
 
-sizes = (256, 512, 768, 1024)
-
-dirset = (
-    ["cpu-{0}-diffusion".format(c) for c in cpuBase],
-    ["gpu-{0}-diffusion".format(g) for g in gpuBase],
-)
-dirs = [s for sublist in dirset for s in sublist]
-
-colors = ["black"] + [plt.cm.cool(i) for i in np.linspace(0, 1, len(dirs) - 1)]
-markers = ("*", "o", "^", "p", "H", "8", "v", "d")
-
-plt.figure(0)
-plt.title("Runtime")
-plt.xlabel(r"Simulation Time")
-plt.ylabel(r"Execution Time")
-
-plt.figure(1)
-plt.title("Residual")
-plt.xlabel(r"Simulation Time")
-plt.ylabel(r"Residual")
-
-plt.figure(2)
-plt.title("Convolution")
-plt.xlabel(r"Simulation Time")
-plt.ylabel(r"Convolution Time")
-
-for nx in sizes:
-    plt.figure(3)
-    plt.title("Runtime with $N_x={0}$".format(nx))
+def plot_benchmarks(files):
+    """Plot median time per step (with 10th-90th percentile bars), achieved
+    bandwidth, and achieved FLOP rate against mesh size for each backend,
+    layout, stencil code, and thread count found in the benchmark CSVs."""
+    series = {}
+    for name in files:
+        with open(name) as f:
+            for row in csv.DictReader(f):
+                key = "{0}-{1} sc{2} t{3}".format(
+                    row["backend"], row["layout"], row["code"], row["threads"]
+                )
+                series.setdefault(key, []).append(row)
+
+    plots = (
+        ("median", "Time per Step (s)", "benchmark-runtime.png", True),
+        ("GBps", "Achieved Bandwidth (GB/s)", "benchmark-bandwidth.png", False),
+        ("GFLOPs", "Achieved Performance (GFLOP/s)", "benchmark-flops.png", False),
+    )
+
+    for column, label, filename, bars in plots:
+        plt.figure()
+        plt.title("Benchmark")
+        plt.xlabel(r"Mesh Size $N_x$")
+        plt.ylabel(label)
+        for j, key in enumerate(sorted(series.keys())):
+            rows = sorted(series[key], key=lambda r: int(r["nx"]))
+            nx = np.array([int(r["nx"]) for r in rows])
+            y = np.array([float(r[column]) for r in rows])
+            marker = markers[j % len(markers)]
+            if bars:
+                lo = y - np.array([float(r["p10"]) for r in rows])
+                hi = np.array([float(r["p90"]) for r in rows]) - y
+                plt.errorbar(nx, y, yerr=[lo, hi], marker=marker, label=key, capsize=2)
+            else:
+                plt.plot(nx, y, "-", marker=marker, label=key)
+        if bars:
+            plt.yscale("log")
+        plt.legend(loc="best", fontsize="x-small")
+        plt.savefig(filename, dpi=300, bbox_inches="tight")
+        plt.close()
+
+
+def plot_runlogs():
+    """Plot runlogs from full simulations, renamed scaling_<nx>.csv."""
+    cpuBase = ("serial", "openmp", "tbb")
+    gpuBase = ("cuda", "openacc", "opencl")
+
+    sizes = (256, 512, 768, 1024)
+
+    dirset = (
+        ["cpu-{0}-diffusion".format(c) for c in cpuBase],
+        ["gpu-{0}-diffusion".format(g) for g in gpuBase],
+    )
+    dirs = [s for sublist in dirset for s in sublist]
+
+    colors = ["black"] + [plt.cm.cool(i) for i in np.linspace(0, 1, len(dirs) - 1)]
+    markers = ("*", "o", "^", "p", "H", "8", "v", "d")
+
+    plt.figure(0)
+    plt.title("Runtime")
     plt.xlabel(r"Simulation Time")
     plt.ylabel(r"Execution Time")
 
-    plt.figure(4)
-    plt.title("Residual with $N_x={0}$".format(nx))
+    plt.figure(1)
+    plt.title("Residual")
     plt.xlabel(r"Simulation Time")
     plt.ylabel(r"Residual")
 
-    plt.figure(5)
-    plt.title("Diffusion with $N_x={0}$".format(nx))
+    plt.figure(2)
+    plt.title("Convolution")
     plt.xlabel(r"Simulation Time")
     plt.ylabel(r"Convolution Time")
 
-    plt.figure(6)
-    plt.title("I/O with $N_x={0}$".format(nx))
-    plt.xlabel(r"Simulation Time")
-    plt.ylabel(r"I/O Time")
-
-    for j, dirname in enumerate(dirs):
-        datdir = "../{0}".format(dirname)
-        logfile = "{0}/scaling_{1}.csv".format(datdir, nx)
-        if path.isdir(datdir) and len(glob.glob(logfile)) > 0:
-            base = path.basename(datdir)
-            step, sim_time, wrss, conv_time, step_time, IO_time, soln_time, run_time = np.loadtxt(
-                logfile, skiprows=1, delimiter=",", unpack=True
-            )
-
-            plt.figure(0)
-            plt.plot(sim_time, run_time, "-", color=colors[j], marker=markers[j])
-
-            plt.figure(1)
-            plt.plot(sim_time, wrss, "-", color=colors[j], marker=markers[j])
-
-            plt.figure(2)
-            plt.plot(sim_time, step_time, "-", color=colors[j], marker=markers[j])
-
-            plt.figure(3)
-            plt.plot(
-                sim_time,
-                run_time,
-                "-",
-                color=colors[j],
-                marker=markers[j],
-                label=dirs[j],
-            )
-
-            plt.figure(4)
-            plt.plot(
-                sim_time, wrss, "-", color=colors[j], marker=markers[j], label=dirs[j]
-            )
-
-            plt.figure(5)
-            plt.plot(
-                sim_time,
-                step_time,
-                "-",
-                color=colors[j],
-                marker=markers[j],
-                label=dirs[j],
-            )
-
-            plt.figure(6)
-            plt.plot(
-                sim_time,
-                IO_time,
-                "-",
-                color=colors[j],
-                marker=markers[j],
-                label=dirs[j],
-            )
-        else:
-            print(
-                "Invalid argument: {0} is not a directory, or contains no usable data.".format(
-                    datdir
+    for nx in sizes:
+        plt.figure(3)
+        plt.title("Runtime with $N_x={0}$".format(nx))
+        plt.xlabel(r"Simulation Time")
+        plt.ylabel(r"Execution Time")
+
+        plt.figure(4)
+        plt.title("Residual with $N_x={0}$".format(nx))
+        plt.xlabel(r"Simulation Time")
+        plt.ylabel(r"Residual")
+
+        plt.figure(5)
+        plt.title("Diffusion with $N_x={0}$".format(nx))
+        plt.xlabel(r"Simulation Time")
+        plt.ylabel(r"Convolution Time")
+
+        plt.figure(6)
+        plt.title("I/O with $N_x={0}$".format(nx))
+        plt.xlabel(r"Simulation Time")
+        plt.ylabel(r"I/O Time")
+
+        for j, dirname in enumerate(dirs):
+            datdir = "../{0}".format(dirname)
+            logfile = "{0}/scaling_{1}.csv".format(datdir, nx)
+            if path.isdir(datdir) and len(glob.glob(logfile)) > 0:
+                base = path.basename(datdir)
+                step, sim_time, wrss, conv_time, step_time, IO_time, soln_time, run_time = np.loadtxt(
+                    logfile, skiprows=1, delimiter=",", usecols=range(8), unpack=True
                 )
-            )
-            print("Usage: {0}".format(argv[0]))
 
-    plt.figure(3)
-    plt.legend(loc="best")
-    plt.savefig("all-runtime-{0}.png".format(nx), dpi=300, bbox_inches="tight")
-    plt.close()
+                plt.figure(0)
+                plt.plot(sim_time, run_time, "-", color=colors[j], marker=markers[j])
+
+                plt.figure(1)
+                plt.plot(sim_time, wrss, "-", color=colors[j], marker=markers[j])
 
-    plt.figure(4)
-    plt.legend(loc="best")
-    plt.savefig("all-residual-{0}.png".format(nx), dpi=300, bbox_inches="tight")
+                plt.figure(2)
+                plt.plot(sim_time, step_time, "-", color=colors[j], marker=markers[j])
+
+                plt.figure(3)
+                plt.plot(
+                    sim_time,
+                    run_time,
+                    "-",
+                    color=colors[j],
+                    marker=markers[j],
+                    label=dirs[j],
+                )
+
+                plt.figure(4)
+                plt.plot(
+                    sim_time, wrss, "-", color=colors[j], marker=markers[j], label=dirs[j]
+                )
+
+                plt.figure(5)
+                plt.plot(
+                    sim_time,
+                    step_time,
+                    "-",
+                    color=colors[j],
+                    marker=markers[j],
+                    label=dirs[j],
+                )
+
+                plt.figure(6)
+                plt.plot(
+                    sim_time,
+                    IO_time,
+                    "-",
+                    color=colors[j],
+                    marker=markers[j],
+                    label=dirs[j],
+                )
+            else:
+                print(
+                    "Invalid argument: {0} is not a directory, or contains no usable data.".format(
+                        datdir
+                    )
+                )
+                print("Usage: {0}".format(argv[0]))
+
+        plt.figure(3)
+        plt.legend(loc="best")
+        plt.savefig("all-runtime-{0}.png".format(nx), dpi=300, bbox_inches="tight")
+        plt.close()
+
+        plt.figure(4)
+        plt.legend(loc="best")
+        plt.savefig("all-residual-{0}.png".format(nx), dpi=300, bbox_inches="tight")
+        plt.close()
+
+        plt.figure(5)
+        plt.legend(loc="best")
+        plt.savefig("all-diffusion-{0}.png".format(nx), dpi=300, bbox_inches="tight")
+        plt.close()
+
+        plt.figure(6)
+        plt.legend(loc="best")
+        plt.savefig("output_{0}.png".format(nx), dpi=300, bbox_inches="tight")
+        plt.close()
+
+    plt.figure(0)
+    plt.savefig("all-runtimes.png", dpi=300, bbox_inches="tight")
     plt.close()
 
-    plt.figure(5)
-    plt.legend(loc="best")
-    plt.savefig("all-diffusion-{0}.png".format(nx), dpi=300, bbox_inches="tight")
+    plt.figure(1)
+    plt.savefig("all-residuals.png", dpi=300, bbox_inches="tight")
     plt.close()
 
-    plt.figure(6)
-    plt.legend(loc="best")
-    plt.savefig("output_{0}.png".format(nx), dpi=300, bbox_inches="tight")
+    plt.figure(2)
+    plt.savefig("all-diffusions.png", dpi=300, bbox_inches="tight")
     plt.close()
 
-plt.figure(0)
-plt.savefig("all-runtimes.png", dpi=300, bbox_inches="tight")
-plt.close()
 
-plt.figure(1)
-plt.savefig("all-residuals.png", dpi=300, bbox_inches="tight")
-plt.close()
+markers = ("*", "o", "^", "p", "H", "8", "v", "d")
+
+benchmarks = sorted(glob.glob("benchmark-*.csv"))
+if len(benchmarks) > 0:
+    plot_benchmarks(benchmarks)
 
-plt.figure(2)
-plt.savefig("all-diffusions.png", dpi=300, bbox_inches="tight")
-plt.close()
+if len(glob.glob("../*-diffusion/scaling_*.csv")) > 0:
+    plot_runlogs()
@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# HiPerC: High Performance Computing Strategies for Boundary Value Problems
+# written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+#
+# This software was developed at the National Institute of Standards and Technology
+# by employees of the Federal Government in the course of their official duties.
+# Pursuant to title 17 section 105 of the United States Code this software is not
+# subject to copyright protection and is in the public domain. NIST assumes no
+# responsibility whatsoever for the use of this software by other parties, and makes
+# no guarantees, expressed or implied, about its quality, reliability, or any other
+# characteristic. We would appreciate acknowledgement if the software is used.
+#
+# This software can be redistributed and/or modified freely provided that any
+# derivative works bear some notice that they are derived from it, and any modified
+# versions bear some notice that they have been modified.
+#
+# Questions/comments to Trevor Keller (trevor.keller@nist.gov)
+
+# This script compares tile traversal orders (A/B) for the tiled OpenMP and TBB
+# diffusion programs on the square meshes used by diffusion-scaling-experiment.sh:
+# 256, 512, 768, 1024, 1280, 1536, 1792, & 2048 points per dimension. Order 0 is
+# the original row-major scheduling (omp for / blocked_range2d); orders 1 and 2
+# sweep tiles along Morton and Hilbert curves, with contiguous chunks per thread.
+# Per-step convolution and update times are tabulated in tile-order.csv.
+#
+# Usage: ./tile-order-experiment.sh [steps]
+
+STEPS=${1:-1000}
+DATADIR=$(pwd)
+ROOTDIR=$(dirname "${DATADIR}")
+WORKDIR=$(mktemp -d)
+RESULTS="${DATADIR}/tile-order.csv"
+
+for backend in openmp tbb
+do
+	make -C "${ROOTDIR}/cpu-${backend}-diffusion" diffusion-tiled || exit 1
+done
+
+echo "backend,nx,order,steps,conv_per_step,update_per_step" > "${RESULTS}"
+
+cd "${WORKDIR}"
+for i in {1..8}
+do
+	NX=$((256 * i))
+	DX=$(awk "BEGIN {print 1.0 / ${i}}")
+	for backend in openmp tbb
+	do
+		for order in 0 1 2
+		do
+			cat > params.txt <<-PARAMS
+				nx ${NX}
+				ny ${NX}
+				dx ${DX}
+				dy ${DX}
+				bx 32
+				by 32
+				ns ${STEPS}
+				nc ${STEPS}
+				dc 0.00625
+				co 0.1
+				sc 3 53
+				to ${order}
+			PARAMS
+			"${ROOTDIR}/cpu-${backend}-diffusion/diffusion-tiled" params.txt > /dev/null
+			tail -n 1 runlog.csv | awk -F, -v b=${backend} -v n=${NX} -v o=${order} -v s=${STEPS} \
+				'{printf "%s,%i,%i,%i,%e,%e\n", b, n, o, s, $4/s, $5/s}' | tee -a "${RESULTS}"
+			rm -f diffusion.*.png diffusion.*.csv runlog.csv
+		done
+	done
+done
+
+cd "${DATADIR}"
+rm -rf "${WORKDIR}"
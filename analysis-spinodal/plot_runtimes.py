@@ -82,7 +82,7 @@ for nx in sizes:
         if path.isdir(datdir) and len(glob.glob(logfile)) > 0:
             base = path.basename(datdir)
             step, sim_time, energy, conv_time, step_time, IO_time, run_time = np.loadtxt(
-                logfile, skiprows=1, delimiter=",", unpack=True
+                logfile, skiprows=1, delimiter=",", usecols=range(7), unpack=True
             )
 
             plt.figure(0)
@@ -0,0 +1,422 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  benchmark.cpp
+ \brief In-process benchmark driver for the CPU diffusion kernels
+
+ Each CPU backend links this driver against its own kernels (\c make
+ \c benchmark), so a single process sweeps mesh sizes, stencil codes, field
+ layouts, and thread counts without re-reading parameter files or writing
+ images. Every case is warmed up, then timed over several repetitions; the
+ median and 10th/90th percentile time per step are reported together with the
+ achieved bandwidth and floating-point rate, as CSV and JSON for
+ plot_runtimes.py.
+
+ Usage: \c ./benchmark [-n sizes] [-s codes] [-l layouts] [-t threads]
+ [-w warmup steps] [-r repetitions] [-k steps per repetition] [-o prefix],
+ where lists are comma-separated, \a e.g. \c -n \c 256,512 \c -s \c 53,93
+ \c -l \c rows,tiles \c -t \c 1,2,4. The OpenMP backend adds the layout
+ \c persistent: rows marched by march_persistent(), one parallel region per
+ repetition. On small meshes, its time per step less that of \c rows is the
+ fork, join, and barrier overhead the persistent region saves. Every backend
+ adds the layout \c stencil: rows stepped by stencil::convolve_update(),
+ four whole rows per block, on the executor matching the backend, so the
+ generic front end can be compared with the hand-written kernels.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef BENCHMARK_TBB
+#include <tbb/global_control.h>
+#include <tbb/info.h>
+#endif
+
+/* The TBB backend compiles the common code as C++; the others as C. */
+#ifndef BENCHMARK_TBB
+extern "C" {
+#endif
+#include "boundaries.h"
+#include "mesh.h"
+#include "numerics.h"
+#include "roofline.h"
+#include "tiles.h"
+#ifdef BENCHMARK_PERSISTENT
+#include "openmp_march.h"
+#endif
+#ifndef BENCHMARK_TBB
+}
+#endif
+#include "stencil.h"
+
+#ifndef BENCHMARK_BACKEND
+/**
+ \brief Name of the backend whose kernels are linked, set by the Makefile
+*/
+#define BENCHMARK_BACKEND "unknown"
+#endif
+
+/**
+ \brief One point in the parameter sweep, and what was measured there
+*/
+struct BenchmarkCase {
+	/**
+	 Field layout: "rows" for \c fp_t**, "tiles" for struct Tiles, or
+	 "persistent" for \c fp_t** in a single parallel region
+	*/
+	std::string layout;
+
+	/**
+	 Mesh size, stencil code, mask width, and thread count
+	*/
+	int nx, code, nm, threads;
+
+	/**
+	 Seconds per step for each repetition, sorted ascending
+	*/
+	std::vector<double> samples;
+
+	/**
+	 Analytical bytes moved and floating-point operations per step
+	*/
+	double bytes, flops;
+};
+
+/**
+ \brief Split a comma-separated list of integers
+*/
+static std::vector<int> parse_int_list(const char* text)
+{
+	std::vector<int> values;
+	std::string item;
+	for (const char* p = text; ; p++) {
+		if (*p == ',' || *p == '\0') {
+			if (!item.empty())
+				values.push_back(atoi(item.c_str()));
+			item.clear();
+			if (*p == '\0')
+				break;
+		} else {
+			item += *p;
+		}
+	}
+	return values;
+}
+
+/**
+ \brief Split a comma-separated list of words
+*/
+static std::vector<std::string> parse_word_list(const char* text)
+{
+	std::vector<std::string> values;
+	std::string item;
+	for (const char* p = text; ; p++) {
+		if (*p == ',' || *p == '\0') {
+			if (!item.empty())
+				values.push_back(item);
+			item.clear();
+			if (*p == '\0')
+				break;
+		} else {
+			item += *p;
+		}
+	}
+	return values;
+}
+
+/**
+ \brief Linearly interpolated percentile \a q (0 to 100) of sorted samples
+*/
+static double percentile(const std::vector<double>& sorted, const double q)
+{
+	if (sorted.empty())
+		return 0.;
+	const double x = 0.01 * q * (sorted.size() - 1);
+	const size_t lo = (size_t)std::floor(x);
+	const size_t hi = std::min(lo + 1, sorted.size() - 1);
+	return sorted[lo] + (x - lo) * (sorted[hi] - sorted[lo]);
+}
+
+/**
+ \brief Run one case: allocate, warm up, then time \a reps repetitions of \a steps steps
+*/
+static void run_case(BenchmarkCase& bc, const int warmup, const int reps, const int steps)
+{
+	fp_t **conc_old, **conc_new, **conc_lap, **mask_lap;
+	const int nx = bc.nx, ny = bc.nx, nm = bc.nm;
+	const fp_t dx = 256. / nx, dy = 256. / ny, D = 0.00625;
+	const fp_t dt = (0.1 * dx * dx) / (4.0 * D);
+	const bool tiled = (bc.layout == "tiles");
+	#ifdef BENCHMARK_PERSISTENT
+	const bool persistent = (bc.layout == "persistent");
+	#endif
+	const bool generic = (bc.layout == "stencil");
+	#if defined(BENCHMARK_TBB)
+	const stencil::TBB exec = {{nx, 4}, NULL};
+	#elif defined(_OPENMP)
+	const stencil::OpenMP exec = {{nx, 4}};
+	#else
+	const stencil::Serial exec = {{nx, 4}};
+	#endif
+	struct Tiles tile_old, tile_new, tile_lap;
+
+	make_arrays(&conc_old, &conc_new, &conc_lap, &mask_lap, nx, ny, nm);
+	set_mask(dx, dy, bc.code, mask_lap, nm);
+	apply_initial_conditions(conc_old, nx, ny, nm);
+
+	if (tiled) {
+		make_tiles(&tile_old, nx, ny, 32, 32, nm);
+		make_tiles(&tile_new, nx, ny, 32, 32, nm);
+		make_tiles(&tile_lap, nx, ny, 32, 32, nm);
+		rowmajor_to_tiles(conc_old, &tile_old);
+	}
+
+	/* analytical traffic and work: see the note in main() */
+	struct Roofline roof;
+	roofline_model(mask_lap, nx, ny, nm, &roof);
+	bc.bytes = roof.conv_bytes + roof.step_bytes;
+	bc.flops = roof.conv_flops + roof.step_flops;
+
+	auto take_steps = [&](const int n) {
+		#ifdef BENCHMARK_PERSISTENT
+		if (persistent) {
+			march_persistent(&conc_old, &conc_new, conc_lap, mask_lap, nx, ny, nm, D, dt, n, 0, 0);
+			return;
+		}
+		#endif
+		for (int s = 0; s < n; s++) {
+			if (tiled) {
+				apply_boundary_conditions_tiled(&tile_old, nm);
+				compute_convolution_tiled(&tile_old, &tile_lap, mask_lap, nm);
+				update_composition_tiled(&tile_old, &tile_lap, &tile_new, nm, D, dt);
+				swap_tiles(&tile_old, &tile_new);
+			} else if (generic) {
+				apply_boundary_conditions(conc_old, nx, ny, nm);
+				stencil::convolve_update(exec, conc_old, conc_new, mask_lap, nx, ny, nm, D, dt);
+				swap_pointers(&conc_old, &conc_new);
+			} else {
+				apply_boundary_conditions(conc_old, nx, ny, nm);
+				compute_convolution(conc_old, conc_lap, mask_lap, nx, ny, nm);
+				update_composition(conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
+				swap_pointers(&conc_old, &conc_new);
+			}
+		}
+	};
+
+	take_steps(warmup);
+
+	bc.samples.clear();
+	for (int r = 0; r < reps; r++) {
+		const auto start = std::chrono::steady_clock::now();
+		take_steps(steps);
+		const auto stop = std::chrono::steady_clock::now();
+		bc.samples.push_back(std::chrono::duration<double>(stop - start).count() / steps);
+	}
+	std::sort(bc.samples.begin(), bc.samples.end());
+
+	if (tiled) {
+		free_tiles(&tile_old);
+		free_tiles(&tile_new);
+		free_tiles(&tile_lap);
+	}
+	free_arrays(conc_old, conc_new, conc_lap, mask_lap);
+}
+
+/**
+ \brief Write results as CSV, one row per case
+*/
+static void write_results_csv(const char* name, const std::vector<BenchmarkCase>& cases,
+                              const int reps, const int steps)
+{
+	FILE* output = fopen(name, "w");
+	if (output == NULL) {
+		printf("Error: unable to open %s for output. Check permissions.\n", name);
+		exit(-1);
+	}
+
+	fprintf(output, "backend,layout,nx,ny,code,nm,threads,reps,steps,"
+	                "median,p10,p90,min,max,GBps,GFLOPs,intensity\n");
+	for (const BenchmarkCase& bc : cases) {
+		const double median = percentile(bc.samples, 50.);
+		fprintf(output, "%s,%s,%i,%i,%i,%i,%i,%i,%i,%e,%e,%e,%e,%e,%f,%f,%f\n",
+		        BENCHMARK_BACKEND, bc.layout.c_str(), bc.nx, bc.nx, bc.code, bc.nm, bc.threads,
+		        reps, steps, median, percentile(bc.samples, 10.), percentile(bc.samples, 90.),
+		        bc.samples.front(), bc.samples.back(),
+		        1.e-9 * bc.bytes / median, 1.e-9 * bc.flops / median, bc.flops / bc.bytes);
+	}
+
+	fclose(output);
+}
+
+/**
+ \brief Write results as JSON: an array of objects, one per case, with raw samples
+*/
+static void write_results_json(const char* name, const std::vector<BenchmarkCase>& cases,
+                               const int reps, const int steps)
+{
+	FILE* output = fopen(name, "w");
+	if (output == NULL) {
+		printf("Error: unable to open %s for output. Check permissions.\n", name);
+		exit(-1);
+	}
+
+	fprintf(output, "[\n");
+	for (size_t c = 0; c < cases.size(); c++) {
+		const BenchmarkCase& bc = cases[c];
+		const double median = percentile(bc.samples, 50.);
+		fprintf(output, "  {\"backend\": \"%s\", \"layout\": \"%s\", \"nx\": %i, \"ny\": %i, "
+		                "\"code\": %i, \"nm\": %i, \"threads\": %i, \"reps\": %i, \"steps\": %i,\n",
+		        BENCHMARK_BACKEND, bc.layout.c_str(), bc.nx, bc.nx, bc.code, bc.nm,
+		        bc.threads, reps, steps);
+		fprintf(output, "   \"median\": %e, \"p10\": %e, \"p90\": %e, \"min\": %e, \"max\": %e,\n",
+		        median, percentile(bc.samples, 10.), percentile(bc.samples, 90.),
+		        bc.samples.front(), bc.samples.back());
+		fprintf(output, "   \"bytes\": %e, \"flops\": %e, \"GBps\": %f, \"GFLOPs\": %f,\n",
+		        bc.bytes, bc.flops, 1.e-9 * bc.bytes / median, 1.e-9 * bc.flops / median);
+		fprintf(output, "   \"samples\": [");
+		for (size_t r = 0; r < bc.samples.size(); r++)
+			fprintf(output, "%s%e", (r == 0) ? "" : ", ", bc.samples[r]);
+		fprintf(output, "]}%s\n", (c + 1 < cases.size()) ? "," : "");
+	}
+	fprintf(output, "]\n");
+
+	fclose(output);
+}
+
+/**
+ \brief Sweep the requested cases and write \a prefix.csv and \a prefix.json
+
+ Bytes and flops per step are the sum of both kernels in roofline_model(),
+ five values per point in all. Boundary conditions are included in the
+ timing, not in the model. The serial build runs one thread only.
+*/
+int main(int argc, char* argv[])
+{
+	std::vector<int> sizes = {256, 512, 768, 1024, 1280, 1536, 1792, 2048};
+	std::vector<int> codes = {53, 93, 95};
+	std::vector<std::string> layouts = {"rows", "tiles"};
+	std::vector<int> threads;
+	int warmup = 10, reps = 10, steps = 100;
+	std::string prefix = "benchmark";
+	int opt;
+
+	#if defined(_OPENMP)
+	threads.push_back(omp_get_max_threads());
+	#elif defined(BENCHMARK_TBB)
+	threads.push_back(tbb::info::default_concurrency());
+	#else
+	threads.push_back(1);
+	#endif
+
+	while ((opt = getopt(argc, argv, "n:s:l:t:w:r:k:o:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				sizes = parse_int_list(optarg);
+				break;
+			case 's':
+				codes = parse_int_list(optarg);
+				break;
+			case 'l':
+				layouts = parse_word_list(optarg);
+				break;
+			case 't':
+				threads = parse_int_list(optarg);
+				break;
+			case 'w':
+				warmup = atoi(optarg);
+				break;
+			case 'r':
+				reps = atoi(optarg);
+				break;
+			case 'k':
+				steps = atoi(optarg);
+				break;
+			case 'o':
+				prefix = optarg;
+				break;
+			default:
+				printf("Usage: %s [-n sizes] [-s codes] [-l layouts] [-t threads] "
+				       "[-w warmup] [-r reps] [-k steps] [-o prefix]\n", argv[0]);
+				exit(-1);
+		}
+	}
+
+	if (reps < 1 || steps < 1) {
+		printf("Error: repetitions and steps must be positive.\n");
+		exit(-1);
+	}
+
+	#if !defined(_OPENMP) && !defined(BENCHMARK_TBB)
+	for (const int nthreads : threads) {
+		if (nthreads != 1) {
+			printf("Error: the %s backend runs one thread, not %i.\n", BENCHMARK_BACKEND, nthreads);
+			exit(-1);
+		}
+	}
+	#endif
+
+	for (const std::string& layout : layouts) {
+		#ifdef BENCHMARK_PERSISTENT
+		const bool known = (layout == "rows" || layout == "tiles" || layout == "stencil" || layout == "persistent");
+		#else
+		const bool known = (layout == "rows" || layout == "tiles" || layout == "stencil");
+		#endif
+		if (!known) {
+			printf("Error: layout %s is not available in the %s backend.\n", layout.c_str(), BENCHMARK_BACKEND);
+			exit(-1);
+		}
+	}
+
+	std::vector<BenchmarkCase> cases;
+
+	for (const int nthreads : threads) {
+		#if defined(_OPENMP)
+		omp_set_num_threads(nthreads);
+		#elif defined(BENCHMARK_TBB)
+		tbb::global_control limit(tbb::global_control::max_allowed_parallelism, nthreads);
+		#endif
+
+		for (const std::string& layout : layouts) {
+			for (const int code : codes) {
+				for (const int nx : sizes) {
+					BenchmarkCase bc;
+					bc.layout = layout;
+					bc.nx = nx;
+					bc.code = code;
+					bc.nm = code % 10;
+					bc.threads = nthreads;
+
+					run_case(bc, warmup, reps, steps);
+					cases.push_back(bc);
+
+					const double median = percentile(bc.samples, 50.);
+					printf("%-8s %-5s nx=%5i code=%3i threads=%3i  median %.3e s/step "
+					       "[p10 %.3e, p90 %.3e]  %7.2f GB/s  %7.2f GFLOP/s\n",
+					       BENCHMARK_BACKEND, layout.c_str(), nx, code, nthreads, median,
+					       percentile(bc.samples, 10.), percentile(bc.samples, 90.),
+					       1.e-9 * bc.bytes / median, 1.e-9 * bc.flops / median);
+					fflush(stdout);
+				}
+			}
+		}
+	}
+
+	write_results_csv((prefix + ".csv").c_str(), cases, reps, steps);
+	write_results_json((prefix + ".json").c_str(), cases, reps, steps);
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  counters.c
+ \brief Implementation of hardware performance counters for kernel phases
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "counters.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/**
+ \brief File descriptor of each event, or -1 if it is not being counted
+*/
+static int counter_fd[NUM_EVENTS] = {-1, -1, -1, -1};
+
+void open_counters(const int enable)
+{
+	#ifdef __linux__
+	const unsigned long long config[NUM_EVENTS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_STALLED_CYCLES_BACKEND
+	};
+	const char* name[NUM_EVENTS] = {"cycles", "instructions", "LLC misses", "stalled cycles"};
+	struct perf_event_attr attr;
+
+	if (!enable)
+		return;
+
+	for (int e = 0; e < NUM_EVENTS; e++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = config[e];
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		counter_fd[e] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if (counter_fd[e] < 0)
+			printf("Warning: hardware counter for %s unavailable (%s); logging -1.\n",
+			       name[e], strerror(errno));
+		else
+			ioctl(counter_fd[e], PERF_EVENT_IOC_ENABLE, 0);
+	}
+	#else
+	if (enable)
+		printf("Warning: hardware counters require Linux perf_event_open; logging -1.\n");
+	#endif
+}
+
+void close_counters(void)
+{
+	for (int e = 0; e < NUM_EVENTS; e++) {
+		#ifdef __linux__
+		if (counter_fd[e] >= 0)
+			close(counter_fd[e]);
+		#endif
+		counter_fd[e] = -1;
+	}
+}
+
+void read_counters(long long values[NUM_EVENTS])
+{
+	for (int e = 0; e < NUM_EVENTS; e++) {
+		values[e] = -1;
+		#ifdef __linux__
+		if (counter_fd[e] >= 0 && read(counter_fd[e], &values[e], sizeof(long long)) != sizeof(long long))
+			values[e] = -1;
+		#endif
+	}
+}
+
+void accumulate_counters(long long total[NUM_EVENTS], const long long start[NUM_EVENTS])
+{
+	long long stop[NUM_EVENTS];
+
+	read_counters(stop);
+	for (int e = 0; e < NUM_EVENTS; e++) {
+		if (start[e] < 0 || stop[e] < 0 || total[e] < 0)
+			total[e] = -1;
+		else
+			total[e] += stop[e] - start[e];
+	}
+}
+
+void print_counters(FILE* output, const struct Stopwatch* watch)
+{
+	for (int p = 0; p < NUM_PHASES; p++)
+		for (int e = 0; e < NUM_EVENTS; e++)
+			fprintf(output, ",%lld", (counter_fd[e] < 0) ? -1 : watch->events[p][e]);
+}
@@ -0,0 +1,93 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  counters.h
+ \brief Declaration of hardware performance counters for kernel phases
+*/
+
+/** \cond SuppressGuard */
+#ifndef _COUNTERS_H_
+#define _COUNTERS_H_
+/** \endcond */
+
+#include <stdio.h>
+#include "type.h"
+
+/**
+ \brief Index of compute_convolution() in Stopwatch::events
+*/
+#define PHASE_CONV 0
+
+/**
+ \brief Index of update_composition() in Stopwatch::events
+*/
+#define PHASE_STEP 1
+
+/**
+ \brief Index of apply_boundary_conditions() in Stopwatch::events
+*/
+#define PHASE_BC 2
+
+/**
+ \brief Index of check_solution() in Stopwatch::events
+*/
+#define PHASE_SOLN 3
+
+/**
+ \brief Column names appended to runlog.csv by print_counters()
+*/
+#define COUNTERS_HEADER \
+	",conv_cycles,conv_instructions,conv_llc_misses,conv_stalls" \
+	",step_cycles,step_instructions,step_llc_misses,step_stalls" \
+	",bc_cycles,bc_instructions,bc_llc_misses,bc_stalls" \
+	",soln_cycles,soln_instructions,soln_llc_misses,soln_stalls"
+
+/**
+ \brief Open hardware counters for this process, if \a enable is nonzero
+
+ Uses Linux \c perf_event_open to count user-space cycles, instructions,
+ last-level cache misses, and backend stalled cycles. Counters are inherited
+ by threads created afterwards, so call this before the first parallel region
+ and the counts will include every OpenMP or TBB worker. Events that cannot
+ be opened -- common in containers, virtual machines, or when
+ \c /proc/sys/kernel/perf_event_paranoid forbids it -- are reported once and
+ then read as -1; the simulation is unaffected.
+*/
+void open_counters(const int enable);
+
+/**
+ \brief Close any counters opened by open_counters()
+*/
+void close_counters(void);
+
+/**
+ \brief Read current counts of all events into \a values, -1 if unavailable
+*/
+void read_counters(long long values[NUM_EVENTS]);
+
+/**
+ \brief Add the events counted since \a start was read into \a total
+
+ Typical usage brackets a kernel:
+ \code
+ read_counters(start);
+ compute_convolution(...);
+ accumulate_counters(watch.events[PHASE_CONV], start);
+ \endcode
+*/
+void accumulate_counters(long long total[NUM_EVENTS], const long long start[NUM_EVENTS]);
+
+/**
+ \brief Append the cumulative event counts named by #COUNTERS_HEADER
+
+ Each value is preceded by a comma. No newline is written. When only a
+ sample of steps is timed (see struct Sampler), counts cover those steps.
+*/
+void print_counters(FILE* output, const struct Stopwatch* watch);
+
+/** \cond SuppressGuard */
+#endif /* _COUNTERS_H_ */
+/** \endcond */
@@ -0,0 +1,284 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  integrator.c
+ \brief Implementation of multi-stage explicit time integrators for diffusion benchmarks
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "boundaries.h"
+#include "integrator.h"
+#include "numerics.h"
+#include "timer.h"
+
+/**
+ \brief Allocate an \a nx \f$\times\f$ \a ny field, as make_arrays()
+*/
+static fp_t** make_field(const int nx, const int ny)
+{
+	fp_t** field = (fp_t**)calloc(ny, sizeof(fp_t*));
+	field[0] = (fp_t*)calloc(nx * ny, sizeof(fp_t));
+	for (int j = 1; j < ny; j++)
+		field[j] = &(field[0][nx * j]);
+	return field;
+}
+
+static void free_field(fp_t** field)
+{
+	if (field != NULL) {
+		free(field[0]);
+		free(field);
+	}
+}
+
+/**
+ \brief Chebyshev polynomials of the first kind and two derivatives at \a x, orders 0 to \a s
+*/
+static void chebyshev(const int s, const fp_t x, fp_t* T, fp_t* dT, fp_t* ddT)
+{
+	T[0] = 1.;
+	dT[0] = 0.;
+	ddT[0] = 0.;
+	T[1] = x;
+	dT[1] = 1.;
+	ddT[1] = 0.;
+	for (int j = 2; j < s+1; j++) {
+		T[j] = 2. * x * T[j-1] - T[j-2];
+		dT[j] = 2. * T[j-1] + 2. * x * dT[j-1] - dT[j-2];
+		ddT[j] = 4. * dT[j-1] + 2. * x * ddT[j-1] - ddT[j-2];
+	}
+}
+
+/**
+ \brief Coefficients of second-order RKC, after Verwer, Sommeijer, and Hundsdorfer (2004)
+*/
+static void set_rkc_coefficients(struct Integrator* integ)
+{
+	const int s = integ->stages;
+	const fp_t w0 = 1. + (2. / 13.) / (s * s);
+	fp_t T[MAX_STAGES+1], dT[MAX_STAGES+1], ddT[MAX_STAGES+1], b[MAX_STAGES+1];
+
+	chebyshev(s, w0, T, dT, ddT);
+	const fp_t w1 = dT[s] / ddT[s];
+
+	b[0] = b[1] = b[2] = ddT[2] / (dT[2] * dT[2]);
+	for (int j = 3; j < s+1; j++)
+		b[j] = ddT[j] / (dT[j] * dT[j]);
+
+	integ->beta = (1. + w0) / w1;
+	integ->mu_t[1] = b[1] * w1;
+	for (int j = 2; j < s+1; j++) {
+		integ->mu[j] = 2. * b[j] * w0 / b[j-1];
+		integ->nu[j] = -b[j] / b[j-2];
+		integ->mu_t[j] = 2. * b[j] * w1 / b[j-1];
+		integ->gamma_t[j] = -(1. - b[j-1] * T[j-1]) * integ->mu_t[j];
+	}
+}
+
+/**
+ \brief Coefficients of RKL2, after Meyer, Balsara, and Aslam (2014)
+*/
+static void set_rkl2_coefficients(struct Integrator* integ)
+{
+	const int s = integ->stages;
+	const fp_t w1 = 4. / (s * s + s - 2);
+	fp_t b[MAX_STAGES+1];
+
+	b[0] = b[1] = b[2] = 1. / 3.;
+	for (int j = 3; j < s+1; j++)
+		b[j] = (fp_t)(j * j + j - 2) / (2. * j * (j + 1));
+
+	integ->beta = 0.5 * (s * s + s - 2);
+	integ->mu_t[1] = b[1] * w1;
+	for (int j = 2; j < s+1; j++) {
+		integ->mu[j] = (2. * j - 1.) / j * b[j] / b[j-1];
+		integ->nu[j] = -(j - 1.) / j * b[j] / b[j-2];
+		integ->mu_t[j] = integ->mu[j] * w1;
+		integ->gamma_t[j] = -(1. - b[j-1]) * integ->mu_t[j];
+	}
+}
+
+void init_integrator(struct Integrator* integ, const int scheme, const int stages,
+                     const int nx, const int ny)
+{
+	integ->scheme = scheme;
+	integ->rate0 = NULL;
+	integ->stage[0] = integ->stage[1] = integ->stage[2] = NULL;
+	integ->timed = 0;
+	integ->conv_time = 0.;
+	integ->step_time = 0.;
+
+	switch(scheme) {
+		case INTEGRATOR_EULER:
+			integ->stages = 1;
+			integ->beta = 2.;
+			return;
+		case INTEGRATOR_RK2:
+			integ->stages = 2;
+			integ->beta = 2.;
+			break;
+		case INTEGRATOR_RK4:
+			integ->stages = 4;
+			integ->beta = 2.785;
+			break;
+		case INTEGRATOR_RKC:
+		case INTEGRATOR_RKL2:
+			if (stages < 2 || stages > MAX_STAGES) {
+				printf("Error: %i stages requested; RKC and RKL2 take 2 to %i.\n", stages, MAX_STAGES);
+				exit(-1);
+			}
+			integ->stages = stages;
+			if (scheme == INTEGRATOR_RKC)
+				set_rkc_coefficients(integ);
+			else
+				set_rkl2_coefficients(integ);
+			break;
+		default:
+			printf("Error: unknown time integrator %i.\n", scheme);
+			exit(-1);
+	}
+
+	integ->rate0 = make_field(nx, ny);
+	for (int k = 0; k < 3; k++)
+		integ->stage[k] = make_field(nx, ny);
+}
+
+void free_integrator(struct Integrator* integ)
+{
+	free_field(integ->rate0);
+	integ->rate0 = NULL;
+	for (int k = 0; k < 3; k++) {
+		free_field(integ->stage[k]);
+		integ->stage[k] = NULL;
+	}
+}
+
+const char* integrator_name(const struct Integrator* integ)
+{
+	switch(integ->scheme) {
+		case INTEGRATOR_RK2:
+			return "RK2";
+		case INTEGRATOR_RK4:
+			return "RK4";
+		case INTEGRATOR_RKC:
+			return "RKC";
+		case INTEGRATOR_RKL2:
+			return "RKL2";
+		default:
+			return "Euler";
+	}
+}
+
+int integrator_multiple(const struct Integrator* integ, const int checks)
+{
+	int m = (int)(0.5 * integ->beta);
+
+	while (m > 1 && checks % m != 0)
+		m--;
+
+	return (m > 1) ? m : 1;
+}
+
+/**
+ \brief Boundary conditions then convolution of \a conc into \a conc_lap, timed into \a integ
+*/
+static void stage_rate(struct Integrator* integ, fp_t** conc, fp_t** conc_lap, fp_t** mask_lap,
+                       const int nx, const int ny, const int nm)
+{
+	if (!integ->timed) {
+		apply_boundary_conditions(conc, nx, ny, nm);
+		compute_convolution(conc, conc_lap, mask_lap, nx, ny, nm);
+		return;
+	}
+
+	timer_push("boundaries");
+	apply_boundary_conditions(conc, nx, ny, nm);
+	timer_pop();
+
+	timer_push("convolution");
+	compute_convolution(conc, conc_lap, mask_lap, nx, ny, nm);
+	integ->conv_time += timer_pop();
+}
+
+/**
+ \brief combine_stages(), timed into \a integ
+*/
+static void stage_combine(struct Integrator* integ, fp_t** out,
+                          const fp_t c0, fp_t** y0, const fp_t c1, fp_t** y1, const fp_t c2, fp_t** y2,
+                          const fp_t c3, fp_t** l0, const fp_t c4, fp_t** l1,
+                          const int nx, const int ny, const int nm)
+{
+	if (!integ->timed) {
+		combine_stages(out, c0, y0, c1, y1, c2, y2, c3, l0, c4, l1, nx, ny, nm);
+		return;
+	}
+
+	timer_push("update");
+	combine_stages(out, c0, y0, c1, y1, c2, y2, c3, l0, c4, l1, nx, ny, nm);
+	integ->step_time += timer_pop();
+}
+
+void integrate_step(struct Integrator* integ, fp_t** conc_old, fp_t** conc_new,
+                    fp_t** conc_lap, fp_t** mask_lap,
+                    const int nx, const int ny, const int nm,
+                    const fp_t D, const fp_t dt, const int timed)
+{
+	const fp_t h = D * dt;
+	fp_t** y = integ->stage[0];
+
+	integ->timed = timed;
+	integ->conv_time = 0.;
+	integ->step_time = 0.;
+
+	if (integ->scheme == INTEGRATOR_EULER) {
+		stage_rate(integ, conc_old, conc_lap, mask_lap, nx, ny, nm);
+		stage_combine(integ, conc_new, 1., conc_old, 0., NULL, 0., NULL, 0., NULL, h, conc_lap, nx, ny, nm);
+		return;
+	}
+
+	stage_rate(integ, conc_old, integ->rate0, mask_lap, nx, ny, nm);
+
+	switch(integ->scheme) {
+		case INTEGRATOR_RK2:
+			/* predictor, then average of the two slopes */
+			stage_combine(integ, y, 1., conc_old, 0., NULL, 0., NULL, h, integ->rate0, 0., NULL, nx, ny, nm);
+			stage_rate(integ, y, conc_lap, mask_lap, nx, ny, nm);
+			stage_combine(integ, conc_new, 0.5, conc_old, 0.5, y, 0., NULL, 0., NULL, 0.5 * h, conc_lap, nx, ny, nm);
+			break;
+
+		case INTEGRATOR_RK4:
+			/* accumulate the weighted slopes in conc_new as each stage completes */
+			stage_combine(integ, conc_new, 1., conc_old, 0., NULL, 0., NULL, h / 6., integ->rate0, 0., NULL, nx, ny, nm);
+			stage_combine(integ, y, 1., conc_old, 0., NULL, 0., NULL, 0.5 * h, integ->rate0, 0., NULL, nx, ny, nm);
+			stage_rate(integ, y, conc_lap, mask_lap, nx, ny, nm);
+			stage_combine(integ, conc_new, 1., conc_new, 0., NULL, 0., NULL, 0., NULL, h / 3., conc_lap, nx, ny, nm);
+			stage_combine(integ, y, 1., conc_old, 0., NULL, 0., NULL, 0., NULL, 0.5 * h, conc_lap, nx, ny, nm);
+			stage_rate(integ, y, conc_lap, mask_lap, nx, ny, nm);
+			stage_combine(integ, conc_new, 1., conc_new, 0., NULL, 0., NULL, 0., NULL, h / 3., conc_lap, nx, ny, nm);
+			stage_combine(integ, y, 1., conc_old, 0., NULL, 0., NULL, 0., NULL, h, conc_lap, nx, ny, nm);
+			stage_rate(integ, y, conc_lap, mask_lap, nx, ny, nm);
+			stage_combine(integ, conc_new, 1., conc_new, 0., NULL, 0., NULL, 0., NULL, h / 6., conc_lap, nx, ny, nm);
+			break;
+
+		default:
+			/* RKC and RKL2 share the three-term recurrence; Y_j lives in stage[j % 3] */
+			stage_combine(integ, integ->stage[1], 1., conc_old, 0., NULL, 0., NULL,
+			              integ->mu_t[1] * h, integ->rate0, 0., NULL, nx, ny, nm);
+			for (int j = 2; j < integ->stages + 1; j++) {
+				fp_t** prev  = integ->stage[(j-1) % 3];
+				fp_t** prev2 = (j == 2) ? conc_old : integ->stage[(j-2) % 3];
+				fp_t** out   = (j == integ->stages) ? conc_new : integ->stage[j % 3];
+				const fp_t mu = integ->mu[j];
+				const fp_t nu = integ->nu[j];
+
+				stage_rate(integ, prev, conc_lap, mask_lap, nx, ny, nm);
+				stage_combine(integ, out, 1. - mu - nu, conc_old, mu, prev, nu, prev2,
+				              integ->gamma_t[j] * h, integ->rate0, integ->mu_t[j] * h, conc_lap,
+				              nx, ny, nm);
+			}
+	}
+}
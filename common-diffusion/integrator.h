@@ -0,0 +1,163 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  integrator.h
+ \brief Declaration of multi-stage explicit time integrators for diffusion benchmarks
+*/
+
+/** \cond SuppressGuard */
+#ifndef _INTEGRATOR_H_
+#define _INTEGRATOR_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief Forward Euler: one stage, the update_composition() path
+*/
+#define INTEGRATOR_EULER 0
+
+/**
+ \brief Heun's method: two stages, second order
+*/
+#define INTEGRATOR_RK2 1
+
+/**
+ \brief Classical Runge-Kutta: four stages, fourth order
+*/
+#define INTEGRATOR_RK4 2
+
+/**
+ \brief Second-order Runge-Kutta-Chebyshev (RKC) with damping \f$\epsilon = 2/13\f$
+*/
+#define INTEGRATOR_RKC 3
+
+/**
+ \brief Second-order Runge-Kutta-Legendre (RKL2) super-time-stepping
+*/
+#define INTEGRATOR_RKL2 4
+
+/**
+ \brief Most stages accepted for the RKC and RKL2 schemes
+*/
+#define MAX_STAGES 64
+
+/**
+ \brief Explicit multi-stage integrator built from compute_convolution()
+
+ Every stage applies boundary conditions and the backend's own
+ compute_convolution(), then forms a linear combination of earlier stages
+ with combine_stages(), so each scheme runs on any backend that provides
+ that one extra kernel. The Chebyshev (RKC) and Legendre (RKL2) schemes are
+ stabilized: their \a s stages stretch the stable interval along the negative
+ real axis from \f$ 2\f$ (forward Euler) to roughly \f$ 0.65 s^2\f$ and
+ \f$ (s^2+s-2)/2\f$, respectively, which suits the parabolic diffusion
+ operator. Each stage obeys the three-term recurrence
+ \f[ Y_j = \mu_j Y_{j-1} + \nu_j Y_{j-2} + (1-\mu_j-\nu_j) Y_0
+         + \tilde{\mu}_j \Delta t\, L(Y_{j-1}) + \tilde{\gamma}_j \Delta t\, L(Y_0), \f]
+ with \f$ L = D\nabla^2\f$, so only five fields are live at once.
+*/
+struct Integrator {
+	/**
+	 Scheme, one of INTEGRATOR_EULER, INTEGRATOR_RK2, INTEGRATOR_RK4,
+	 INTEGRATOR_RKC, or INTEGRATOR_RKL2
+	*/
+	int scheme;
+
+	/**
+	 Number of stages, \a i.e. convolutions per step
+	*/
+	int stages;
+
+	/**
+	 Length of the stable interval on the negative real axis, in units of
+	 \f$\Delta t\,\lambda_{max}\f$; 2 for forward Euler
+	*/
+	fp_t beta;
+
+	/**
+	 Recurrence coefficients for RKC and RKL2, indexed by stage
+	*/
+	fp_t mu[MAX_STAGES+1], nu[MAX_STAGES+1], mu_t[MAX_STAGES+1], gamma_t[MAX_STAGES+1];
+
+	/**
+	 Scratch fields: \f$ L(Y_0)\f$ and three rotating stage values
+	*/
+	fp_t **rate0, **stage[3];
+
+	/**
+	 Time spent in compute_convolution() and combine_stages() during the last step
+	*/
+	fp_t conv_time, step_time;
+
+	/**
+	 Whether the current step opens timer scopes, see integrate_step()
+	*/
+	int timed;
+};
+
+/**
+ \brief Prepare \a integ for \a scheme with \a stages stages (RKC and RKL2 only)
+
+ Allocates scratch fields of \a nx \f$\times\f$ \a ny when \a scheme is not
+ forward Euler. Unknown schemes or stage counts are fatal.
+*/
+void init_integrator(struct Integrator* integ, const int scheme, const int stages,
+                     const int nx, const int ny);
+
+/**
+ \brief Free scratch fields
+*/
+void free_integrator(struct Integrator* integ);
+
+/**
+ \brief Human-readable name of the scheme
+*/
+const char* integrator_name(const struct Integrator* integ);
+
+/**
+ \brief Whole number of forward-Euler steps \a dt may span
+
+ The largest divisor of \a checks not exceeding \f$\beta/2\f$, so that a
+ step of this many Euler-sized increments stays within the scheme's
+ stability interval and checkpoints fall at the same simulation times as
+ with forward Euler, for comparison of check_solution() at equal
+ \a sim_time.
+*/
+int integrator_multiple(const struct Integrator* integ, const int checks);
+
+/**
+ \brief Advance \a conc_old by \a dt into \a conc_new
+
+ Boundary conditions are applied to \a conc_old and every intermediate stage;
+ \a conc_lap is used as scratch. If \a timed, each stage opens the usual
+ "boundaries", "convolution", and "update" timer scopes and the step's
+ totals are left in \a integ->conv_time and \a integ->step_time; otherwise
+ the step runs untimed, as on the sampler's fast path.
+*/
+void integrate_step(struct Integrator* integ, fp_t** conc_old, fp_t** conc_new,
+                    fp_t** conc_lap, fp_t** mask_lap,
+                    const int nx, const int ny, const int nm,
+                    const fp_t D, const fp_t dt, const int timed);
+
+/* The following is implemented by each CPU backend, alongside
+   update_composition() in numerics.h. */
+
+/**
+ \brief Interior linear combination of stages and rates
+
+ Sets \f$ out = c_0 y_0 + c_1 y_1 + c_2 y_2 + c_3 l_0 + c_4 l_1\f$ for
+ \f$ nm/2 \leq i < nx-nm/2\f$, \f$ nm/2 \leq j < ny-nm/2\f$. Terms whose
+ field is \c NULL are omitted. \a out may alias any input.
+*/
+void combine_stages(fp_t** out,
+                    const fp_t c0, fp_t** y0, const fp_t c1, fp_t** y1, const fp_t c2, fp_t** y2,
+                    const fp_t c3, fp_t** l0, const fp_t c4, fp_t** l1,
+                    const int nx, const int ny, const int nm);
+
+/** \cond SuppressGuard */
+#endif /* _INTEGRATOR_H_ */
+/** \endcond */
@@ -15,6 +15,43 @@
 #include <png.h>
 #include "output.h"
 
+/**
+ \brief Keys read by param_optional_int() and param_optional_fp(), not param_parser()
+
+ \a to: tile traversal order for tiled builds, see set_tile_order() \n
+ \a st: millions of values per STREAM triad array, see stream_triad(); 0 skips it \n
+ \a pc: nonzero to log hardware performance counters, see open_counters() \n
+ \a tr: events kept per thread for trace.json, see open_trace(); 0 disables it \n
+ \a ts: time one step in this many, see struct Sampler \n
+ \a rs: nonzero to choose timed steps at random rather than periodically \n
+ \a eb: nonzero to run ensemble members in SIMD batches, see struct Batch \n
+ \a ti: time integrator, see struct Integrator \n
+ \a is: stages per step for the RKC and RKL2 integrators \n
+ \a ag: composition change across a coarse cell that triggers refinement, see amr_regrid() \n
+ \a ar: steps between regrids of the adaptive mesh \n
+ \a at: change per step below which tiled builds skip steady tiles, see struct Activity; negative sweeps every tile \n
+ \a nz: mesh points along \a z for 3D programs \n
+ \a dz: mesh resolution along \a z for 3D programs; defaults to \a dx \n
+ \a zb: nonzero to stream 3D convolution along \a z in columns, see compute_convolution_3d_blocked() \n
+ \a af: nonzero to fuse \a bx by \a by tiles under a persistent TBB affinity_partitioner, see solve_tiles_affinity() \n
+ \a pl: checkpoints checked and written in flight by the TBB flow graph, see open_pipeline(); 0 disables it \n
+ \a wf: steps the OpenMP tile tasks may run ahead, see march_wavefront(); 0 disables it \n
+ \a pr: nonzero to march the steps between checkpoints in one OpenMP parallel region, see march_persistent() \n
+ \a wt: work-stealing workers including the main thread, see make_scheduler(); 0 starts one per CPU
+*/
+static const char* optional_keys[] = {"to", "st", "pc", "tr", "ts", "rs", "eb", "ti", "is", "ag", "ar", "at", "nz", "dz", "zb", "af", "pl", "wf", "pr", "wt", NULL};
+
+/**
+ \brief Check whether \a key is one of the #optional_keys
+*/
+static int is_optional_key(const char* key)
+{
+	for (int k = 0; optional_keys[k] != NULL; k++)
+		if (strcmp(key, optional_keys[k]) == 0)
+			return 1;
+	return 0;
+}
+
 void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* code,
      fp_t* D, fp_t* dx, fp_t* dy, fp_t* linStab, int* nm, int* nx, int* ny, int* steps)
 {
@@ -87,7 +124,7 @@ void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* co
 					pch = strtok(NULL, " ");
 					*code = atoi(pch);
 					isc = 1;
-				} else {
+				} else if (! is_optional_key(pch)) {
 					printf("Warning: unknown key %s. Ignoring value.\n", pch);
 				}
 			}
@@ -121,6 +158,56 @@ void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* co
 	fclose(input);
 }
 
+/**
+ \brief Copy the value following \a key in the parameter file into \a value
+
+ \return 1 if \a key was found, 0 otherwise
+*/
+static int find_optional(int argc, char* argv[], const char* key, char* value)
+{
+	FILE * input;
+	char buffer[256];
+	char* pch;
+	int found = 0;
+
+	if (argc != 2)
+		return 0;
+
+	input = fopen(argv[1], "r");
+	if (input == NULL)
+		return 0;
+
+	while (!found && fgets(buffer, 256, input) != NULL) {
+		pch = strtok(buffer, " ");
+		if (pch != NULL && strcmp(pch, key) == 0) {
+			pch = strtok(NULL, " ");
+			if (pch != NULL) {
+				strncpy(value, pch, 255);
+				found = 1;
+			}
+		}
+	}
+
+	fclose(input);
+	return found;
+}
+
+void param_optional_int(int argc, char* argv[], const char* key, int* value)
+{
+	char buffer[256] = {'\0'};
+
+	if (find_optional(argc, argv, key, buffer))
+		*value = atoi(buffer);
+}
+
+void param_optional_fp(int argc, char* argv[], const char* key, fp_t* value)
+{
+	char buffer[256] = {'\0'};
+
+	if (find_optional(argc, argv, key, buffer))
+		*value = atof(buffer);
+}
+
 void print_progress(const int step, const int steps)
 {
 	static unsigned long tstart;
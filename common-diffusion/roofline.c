@@ -0,0 +1,118 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  roofline.c
+ \brief Implementation of analytical traffic and work model for diffusion kernels
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "roofline.h"
+#include "timer.h"
+
+void roofline_model(fp_t** mask_lap, const int nx, const int ny, const int nm,
+                    struct Roofline* roof)
+{
+	const fp_t points = (fp_t)(nx - 2 * (nm/2)) * (fp_t)(ny - 2 * (nm/2));
+	int nnz = 0;
+
+	for (int j = 0; j < nm; j++)
+		for (int i = 0; i < nm; i++)
+			if (mask_lap[j][i] != 0.)
+				nnz++;
+
+	roof->conv_bytes = 2. * sizeof(fp_t) * points;
+	roof->conv_flops = 2. * nnz * points;
+	roof->step_bytes = 3. * sizeof(fp_t) * points;
+	roof->step_flops = 3. * points;
+	roof->peak_bw = 0.;
+}
+
+fp_t stream_triad(const int n)
+{
+	const fp_t s = 3.0;
+	fp_t best = 0.;
+	fp_t *a, *b, *c;
+	int i;
+
+	a = (fp_t*)malloc(n * sizeof(fp_t));
+	b = (fp_t*)malloc(n * sizeof(fp_t));
+	c = (fp_t*)malloc(n * sizeof(fp_t));
+	if (a == NULL || b == NULL || c == NULL) {
+		printf("Error: unable to allocate STREAM triad arrays of %i values.\n", n);
+		exit(-1);
+	}
+
+	/* first touch by the threads that will stream the data */
+	#ifdef _OPENMP
+	#pragma omp parallel for
+	#endif
+	for (i = 0; i < n; i++) {
+		a[i] = 0.;
+		b[i] = 1.;
+		c[i] = 2.;
+	}
+
+	for (int trial = 0; trial < 10; trial++) {
+		const double start = GetTimer();
+		#ifdef _OPENMP
+		#pragma omp parallel for
+		#endif
+		for (i = 0; i < n; i++)
+			a[i] = b[i] + s * c[i];
+		const double elapsed = GetTimer() - start;
+		if (elapsed > 0. && 3.e-9 * sizeof(fp_t) * n / elapsed > best)
+			best = 3.e-9 * sizeof(fp_t) * n / elapsed;
+	}
+
+	free(a);
+	free(b);
+	free(c);
+
+	return best;
+}
+
+fp_t achieved_rate(const fp_t per_call, const int calls, const fp_t seconds)
+{
+	return (seconds > 0.) ? 1.e-9 * per_call * calls / seconds : 0.;
+}
+
+void print_roofline(FILE* output, const struct Roofline* roof,
+                    const struct Stopwatch* watch, const int steps)
+{
+	fprintf(output, ",%f,%f,%f,%f,%f,%f,%f",
+	        achieved_rate(roof->conv_bytes, steps, watch->conv),
+	        achieved_rate(roof->conv_flops, steps, watch->conv),
+	        roof->conv_flops / roof->conv_bytes,
+	        achieved_rate(roof->step_bytes, steps, watch->step),
+	        achieved_rate(roof->step_flops, steps, watch->step),
+	        roof->step_flops / roof->step_bytes,
+	        roof->peak_bw);
+}
+
+void summarize_roofline(const struct Roofline* roof,
+                        const struct Stopwatch* watch, const int steps)
+{
+	const fp_t conv_bw = achieved_rate(roof->conv_bytes, steps, watch->conv);
+	const fp_t step_bw = achieved_rate(roof->step_bytes, steps, watch->step);
+
+	printf("Convolution: %8.3f GB/s, %8.3f GFLOP/s, intensity %.3f FLOP/B",
+	       conv_bw, achieved_rate(roof->conv_flops, steps, watch->conv),
+	       roof->conv_flops / roof->conv_bytes);
+	if (roof->peak_bw > 0.)
+		printf(", %5.1f%% of STREAM triad", 100. * conv_bw / roof->peak_bw);
+	printf("\n");
+
+	printf("Update:      %8.3f GB/s, %8.3f GFLOP/s, intensity %.3f FLOP/B",
+	       step_bw, achieved_rate(roof->step_flops, steps, watch->step),
+	       roof->step_flops / roof->step_bytes);
+	if (roof->peak_bw > 0.)
+		printf(", %5.1f%% of STREAM triad", 100. * step_bw / roof->peak_bw);
+	printf("\n");
+
+	if (roof->peak_bw > 0.)
+		printf("STREAM triad: %8.3f GB/s\n", roof->peak_bw);
+}
@@ -0,0 +1,96 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  roofline.h
+ \brief Declaration of analytical traffic and work model for diffusion kernels
+*/
+
+/** \cond SuppressGuard */
+#ifndef _ROOFLINE_H_
+#define _ROOFLINE_H_
+/** \endcond */
+
+#include <stdio.h>
+#include "type.h"
+
+/**
+ \brief Column names appended to runlog.csv by print_roofline()
+*/
+#define ROOFLINE_HEADER ",conv_GBps,conv_GFLOPs,conv_AI,step_GBps,step_GFLOPs,step_AI,peak_GBps"
+
+/**
+ \brief Bytes moved and floating-point operations per call of each kernel
+
+ Traffic is compulsory traffic over the interior mesh points, without
+ write-allocate: compute_convolution() reads \a conc_old and writes
+ \a conc_lap (two values per point); update_composition() reads \a conc_old
+ and \a conc_lap and writes \a conc_new (three values per point). Each
+ nonzero mask coefficient costs one multiply and one add; the update costs
+ three flops per point. Dividing flops by bytes gives the arithmetic
+ intensity that places each phase on a roofline plot.
+*/
+struct Roofline {
+	/**
+	 Bytes and flops per call of compute_convolution()
+	*/
+	fp_t conv_bytes, conv_flops;
+
+	/**
+	 Bytes and flops per call of update_composition()
+	*/
+	fp_t step_bytes, step_flops;
+
+	/**
+	 Measured STREAM triad bandwidth (GB/s), or zero if not measured
+	*/
+	fp_t peak_bw;
+};
+
+/**
+ \brief Derive the traffic and work of one step from the mesh and mask
+
+ Mask sparsity matters: the five-point stencil has 5 nonzero coefficients
+ in a \f$ 3\times 3\f$ mask, while slow_nine_point_Laplacian_stencil()
+ has 9 in a \f$ 5\times 5\f$ mask.
+*/
+void roofline_model(fp_t** mask_lap, const int nx, const int ny, const int nm,
+                    struct Roofline* roof);
+
+/**
+ \brief Measure sustainable memory bandwidth with the STREAM triad, in GB/s
+
+ Computes \f$ a_i = b_i + s c_i \f$ over arrays of \a n values, reporting the
+ best of ten trials and counting three values per element, as STREAM does.
+ Threads are used when compiled with OpenMP; otherwise this measures the
+ bandwidth of a single core. Choose \a n so that the three arrays exceed the
+ last-level cache several times over.
+*/
+fp_t stream_triad(const int n);
+
+/**
+ \brief Achieved rate, in units of \f$ 10^9 \f$ per second, of \a calls calls
+ each costing \a per_call, over \a seconds; zero before any time has elapsed
+*/
+fp_t achieved_rate(const fp_t per_call, const int calls, const fp_t seconds);
+
+/**
+ \brief Append achieved bandwidth, FLOP rate, and arithmetic intensity per phase
+
+ Writes the values named by #ROOFLINE_HEADER, each preceded by a comma, for
+ \a steps calls of each kernel timed by \a watch. No newline is written.
+*/
+void print_roofline(FILE* output, const struct Roofline* roof,
+                    const struct Stopwatch* watch, const int steps);
+
+/**
+ \brief Print a per-phase roofline summary to stdout at the end of a run
+*/
+void summarize_roofline(const struct Roofline* roof,
+                        const struct Stopwatch* watch, const int steps);
+
+/** \cond SuppressGuard */
+#endif /* _ROOFLINE_H_ */
+/** \endcond */
@@ -0,0 +1,96 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  sampling.c
+ \brief Implementation of sampled-step timing for diffusion benchmarks
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include "sampling.h"
+
+void init_sampler(struct Sampler* sampler, const int interval, const int randomized)
+{
+	sampler->interval = (interval > 1) ? interval : 1;
+	sampler->randomized = randomized;
+	sampler->state = 88172645463325252ULL;
+	sampler->steps = 0;
+
+	for (int p = 0; p < NUM_SAMPLED; p++) {
+		sampler->n[p] = 0;
+		sampler->sum[p] = 0.;
+		sampler->sumsq[p] = 0.;
+	}
+}
+
+int sample_step(struct Sampler* sampler)
+{
+	const long step = sampler->steps++;
+
+	if (sampler->interval == 1)
+		return 1;
+
+	if (!sampler->randomized)
+		return (step % sampler->interval == 0);
+
+	/* xorshift64: cheap, and reproducible from run to run */
+	sampler->state ^= sampler->state << 13;
+	sampler->state ^= sampler->state >> 7;
+	sampler->state ^= sampler->state << 17;
+	return (sampler->state % sampler->interval == 0);
+}
+
+void record_sample(struct Sampler* sampler, const int phase, const double seconds)
+{
+	sampler->n[phase]++;
+	sampler->sum[phase] += seconds;
+	sampler->sumsq[phase] += seconds * seconds;
+}
+
+double estimate_total(const struct Sampler* sampler, const int phase, double* ci)
+{
+	const long n = sampler->n[phase];
+	const double N = (double)sampler->steps;
+
+	if (n == 0) {
+		*ci = (sampler->steps > 0) ? -1. : 0.;
+		return 0.;
+	}
+
+	const double mean = sampler->sum[phase] / n;
+
+	if (n >= sampler->steps) {
+		*ci = 0.;
+		return sampler->sum[phase];
+	}
+
+	if (n < 2) {
+		*ci = -1.;
+	} else {
+		const double var = (sampler->sumsq[phase] - n * mean * mean) / (n - 1);
+		const double fpc = 1. - n / N;
+		*ci = 1.96 * N * sqrt(((var > 0.) ? var : 0.) * fpc / n);
+	}
+
+	return N * mean;
+}
+
+void estimate_stopwatch(const struct Sampler* sampler, struct Stopwatch* watch)
+{
+	double ci;
+
+	watch->conv = estimate_total(sampler, SAMPLE_CONV, &ci);
+	watch->step = estimate_total(sampler, SAMPLE_STEP, &ci);
+}
+
+void print_sampling(FILE* output, const struct Sampler* sampler)
+{
+	double conv_ci, step_ci;
+
+	estimate_total(sampler, SAMPLE_CONV, &conv_ci);
+	estimate_total(sampler, SAMPLE_STEP, &step_ci);
+	fprintf(output, ",%f,%f,%li", conv_ci, step_ci, sampler->n[SAMPLE_CONV]);
+}
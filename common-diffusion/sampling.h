@@ -0,0 +1,115 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  sampling.h
+ \brief Declaration of sampled-step timing for diffusion benchmarks
+*/
+
+/** \cond SuppressGuard */
+#ifndef _SAMPLING_H_
+#define _SAMPLING_H_
+/** \endcond */
+
+#include <stdio.h>
+#include "type.h"
+
+/**
+ \brief Index of compute_convolution() samples in struct Sampler
+*/
+#define SAMPLE_CONV 0
+
+/**
+ \brief Index of update_composition() samples in struct Sampler
+*/
+#define SAMPLE_STEP 1
+
+/**
+ \brief Number of phases sampled
+*/
+#define NUM_SAMPLED 2
+
+/**
+ \brief Column names appended to runlog.csv by print_sampling()
+*/
+#define SAMPLING_HEADER ",conv_ci,step_ci,timed_steps"
+
+/**
+ \brief Choice of timed steps, and per-phase statistics over them
+
+ Timing every step of a long run on a small mesh adds two clock reads per
+ kernel per step, plus their jitter. Instead, only every \a interval-th step
+ (or, if \a randomized, each step with probability 1/\a interval) is timed; the
+ rest take an untimed path. Per-phase totals are extrapolated from the mean
+ of the timed steps, with a 95% confidence interval from their variance.
+*/
+struct Sampler {
+	/**
+	 Time one step in \a interval; 1 times every step
+	*/
+	int interval;
+
+	/**
+	 Nonzero to choose timed steps at random rather than periodically
+	*/
+	int randomized;
+
+	/**
+	 State of the xorshift generator used when \a randomized
+	*/
+	unsigned long long state;
+
+	/**
+	 Steps taken so far, timed or not
+	*/
+	long steps;
+
+	/**
+	 Number, sum, and sum of squares of timed samples per phase
+	*/
+	long n[NUM_SAMPLED];
+	double sum[NUM_SAMPLED], sumsq[NUM_SAMPLED];
+};
+
+/**
+ \brief Prepare to time one step in \a interval, periodically or at random
+*/
+void init_sampler(struct Sampler* sampler, const int interval, const int randomized);
+
+/**
+ \brief Count a step, returning nonzero if it should be timed
+
+ Periodic sampling always times the first step.
+*/
+int sample_step(struct Sampler* sampler);
+
+/**
+ \brief Record \a seconds spent in \a phase during a timed step
+*/
+void record_sample(struct Sampler* sampler, const int phase, const double seconds);
+
+/**
+ \brief Extrapolated total over all steps taken, and its 95% confidence half-width
+
+ The half-width includes the finite-population correction, so it vanishes
+ when every step is timed; it is -1 while fewer than two steps are timed.
+*/
+double estimate_total(const struct Sampler* sampler, const int phase, double* ci);
+
+/**
+ \brief Store extrapolated totals in the \a conv and \a step fields of \a watch
+*/
+void estimate_stopwatch(const struct Sampler* sampler, struct Stopwatch* watch);
+
+/**
+ \brief Append the confidence intervals and timed-step count named by #SAMPLING_HEADER
+
+ Each value is preceded by a comma. No newline is written.
+*/
+void print_sampling(FILE* output, const struct Sampler* sampler);
+
+/** \cond SuppressGuard */
+#endif /* _SAMPLING_H_ */
+/** \endcond */
@@ -0,0 +1,257 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  stencil.h
+ \brief Header-only C++ front end mapping one stencil kernel onto every CPU runtime
+
+ A kernel is a lambda of the mesh indices \a i and \a j that reads and writes
+ the fields it captures; the halo width of its widest read fixes the box it
+ may sweep, see interior(). apply() runs the kernel over a box in blocks of
+ the executor's size, the inner loop marked for SIMD: serially with Serial,
+ across OpenMP threads with OpenMP, or across TBB tasks with TBB, defined
+ when the includer sets \c STENCIL_TBB. Graph runtimes such as HTGS and
+ Hedgehog enumerate the same blocks with block_count() and block_box(), and
+ run each one as a task with sweep(). Blocks are traced per thread when
+ trace.h is included first.
+
+ The kernels shared by the backends, convolve(), update(), and
+ convolve_update(), are written once below, so an optimization made here
+ reaches every runtime. Each point sums as compute_convolution() does, so
+ results match the C backends bitwise.
+*/
+
+/** \cond SuppressGuard */
+#ifndef _STENCIL_H_
+#define _STENCIL_H_
+/** \endcond */
+
+#ifdef STENCIL_TBB
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#endif
+#include "type.h"
+
+/** \cond SuppressGuard */
+#if defined(_OPENMP)
+#define STENCIL_SIMD _Pragma("omp simd")
+#elif defined(__GNUC__) && !defined(__clang__)
+#define STENCIL_SIMD _Pragma("GCC ivdep")
+#else
+#define STENCIL_SIMD
+#endif
+
+#ifdef _TRACE_H_
+#define STENCIL_TRACE_BEGIN(start) const unsigned long long start = trace_begin()
+#define STENCIL_TRACE_END(name, start) if (name != NULL) trace_end(name, -1, start)
+#else
+#define STENCIL_TRACE_BEGIN(start)
+#define STENCIL_TRACE_END(name, start)
+#endif
+/** \endcond */
+
+namespace stencil {
+
+/**
+ \brief Half-open box of mesh points [\a x0, \a x1) by [\a y0, \a y1)
+*/
+struct Box {
+	int x0, x1, y0, y1;
+};
+
+/**
+ \brief Points of an \a nx by \a ny field at least \a halo from every edge
+*/
+inline Box interior(const int nx, const int ny, const int halo)
+{
+	Box box = {halo, nx - halo, halo, ny - halo};
+	return box;
+}
+
+/**
+ \brief Block size: columns \a bx and rows \a by swept by one task
+*/
+struct Blocking {
+	int bx, by;
+};
+
+/**
+ \brief Blocks of \a blocking covering \a box, the last in each row and column clipped
+*/
+inline int block_count(const Box& box, const Blocking& blocking)
+{
+	const int nbx = (box.x1 - box.x0 + blocking.bx - 1) / blocking.bx;
+	const int nby = (box.y1 - box.y0 + blocking.by - 1) / blocking.by;
+	return nbx * nby;
+}
+
+/**
+ \brief Block \a b of \a box, counted along rows of blocks
+*/
+inline Box block_box(const Box& box, const Blocking& blocking, const int b)
+{
+	const int nbx = (box.x1 - box.x0 + blocking.bx - 1) / blocking.bx;
+	const int x0 = box.x0 + blocking.bx * (b % nbx);
+	const int y0 = box.y0 + blocking.by * (b / nbx);
+	Box block = {x0, (x0 + blocking.bx < box.x1) ? x0 + blocking.bx : box.x1,
+	             y0, (y0 + blocking.by < box.y1) ? y0 + blocking.by : box.y1};
+	return block;
+}
+
+/**
+ \brief Run \a kernel at every point of \a box on the calling thread, rows outermost
+
+ The inner loop is marked free of loop-carried dependences, so kernels must
+ not write a point another point of the same row reads.
+*/
+template <class Kernel>
+inline void sweep(const Box& box, const Kernel& kernel)
+{
+	for (int j = box.y0; j < box.y1; j++) {
+		STENCIL_SIMD
+		for (int i = box.x0; i < box.x1; i++)
+			kernel(i, j);
+	}
+}
+
+/**
+ \brief Executor sweeping blocks in order on the calling thread
+*/
+struct Serial {
+	Blocking blocking;
+};
+
+/**
+ \brief Executor sweeping blocks across OpenMP threads, statically scheduled
+
+ Without OpenMP it runs as Serial.
+*/
+struct OpenMP {
+	Blocking blocking;
+};
+
+/**
+ \brief Run \a kernel over \a box, block by block, tracing each block as \a name unless NULL
+*/
+template <class Kernel>
+inline void apply(const Serial& exec, const Box& box, const Kernel& kernel, const char* name = NULL)
+{
+	const int blocks = block_count(box, exec.blocking);
+
+	for (int b = 0; b < blocks; b++) {
+		STENCIL_TRACE_BEGIN(start);
+		sweep(block_box(box, exec.blocking, b), kernel);
+		STENCIL_TRACE_END(name, start);
+	}
+}
+
+/**
+ \copydoc apply(const Serial&, const Box&, const Kernel&, const char*)
+*/
+template <class Kernel>
+inline void apply(const OpenMP& exec, const Box& box, const Kernel& kernel, const char* name = NULL)
+{
+	const int blocks = block_count(box, exec.blocking);
+
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule(static)
+	#endif
+	for (int b = 0; b < blocks; b++) {
+		STENCIL_TRACE_BEGIN(start);
+		sweep(block_box(box, exec.blocking, b), kernel);
+		STENCIL_TRACE_END(name, start);
+	}
+}
+
+#ifdef STENCIL_TBB
+/**
+ \brief Executor splitting blocks across TBB tasks
+
+ With \a affinity set, blocks return to the thread that swept them last
+ time the same partitioner was used, whose cache still holds their rows.
+*/
+struct TBB {
+	Blocking blocking;
+	tbb::affinity_partitioner* affinity;
+};
+
+/**
+ \copydoc apply(const Serial&, const Box&, const Kernel&, const char*)
+*/
+template <class Kernel>
+inline void apply(const TBB& exec, const Box& box, const Kernel& kernel, const char* name = NULL)
+{
+	const tbb::blocked_range2d<int> range(box.y0, box.y1, exec.blocking.by,
+	                                      box.x0, box.x1, exec.blocking.bx);
+	auto body = [&](const tbb::blocked_range2d<int>& r) {
+		const Box block = {r.cols().begin(), r.cols().end(), r.rows().begin(), r.rows().end()};
+		STENCIL_TRACE_BEGIN(start);
+		sweep(block, kernel);
+		STENCIL_TRACE_END(name, start);
+	};
+
+	if (exec.affinity != NULL)
+		tbb::parallel_for(range, body, *exec.affinity);
+	else
+		tbb::parallel_for(range, body);
+}
+#endif
+
+/**
+ \brief Discrete Laplacian of \a conc at (\a i, \a j), summing as compute_convolution() does
+*/
+inline fp_t laplacian(fp_t** conc, fp_t** mask_lap, const int nm, const int i, const int j)
+{
+	fp_t value = 0.0;
+	for (int mj = -nm/2; mj < nm/2+1; mj++) {
+		for (int mi = -nm/2; mi < nm/2+1; mi++) {
+			value += mask_lap[mj+nm/2][mi+nm/2] * conc[j+mj][i+mi];
+		}
+	}
+	return value;
+}
+
+/**
+ \brief Store the Laplacian of \a conc_old in \a conc_lap, as compute_convolution() does
+*/
+template <class Exec>
+inline void convolve(const Exec& exec, fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
+                     const int nx, const int ny, const int nm)
+{
+	apply(exec, interior(nx, ny, nm/2), [=](const int i, const int j) {
+		conc_lap[j][i] = laplacian(conc_old, mask_lap, nm, i, j);
+	}, "convolution");
+}
+
+/**
+ \brief Take a forward Euler step from \a conc_lap, as update_composition() does
+*/
+template <class Exec>
+inline void update(const Exec& exec, fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
+                   const int nx, const int ny, const int nm, const fp_t D, const fp_t dt)
+{
+	apply(exec, interior(nx, ny, nm/2), [=](const int i, const int j) {
+		conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
+	}, "update");
+}
+
+/**
+ \brief Convolve and step in one sweep, so the Laplacian is never stored
+*/
+template <class Exec>
+inline void convolve_update(const Exec& exec, fp_t** conc_old, fp_t** conc_new, fp_t** mask_lap,
+                            const int nx, const int ny, const int nm, const fp_t D, const fp_t dt)
+{
+	apply(exec, interior(nx, ny, nm/2), [=](const int i, const int j) {
+		conc_new[j][i] = conc_old[j][i] + dt * D * laplacian(conc_old, mask_lap, nm, i, j);
+	}, "convolution");
+}
+
+} /* namespace stencil */
+
+/** \cond SuppressGuard */
+#endif /* _STENCIL_H_ */
+/** \endcond */
@@ -0,0 +1,358 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  tiles.c
+ \brief Implementation of tiled (blocked) field layout for diffusion benchmarks
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tiles.h"
+#include "trace.h"
+
+void make_tiles(struct Tiles* field, const int nx, const int ny,
+                const int tw, const int th, const int nm)
+{
+	void* data = NULL;
+
+	field->nx = nx;
+	field->ny = ny;
+	field->tw = tw;
+	field->th = th;
+	field->hw = nm/2;
+	field->ntx = (nx + tw - 1) / tw;
+	field->nty = (ny + th - 1) / th;
+	field->pitch = TILE_ALIGN * ((tw + 2 * field->hw + TILE_ALIGN - 1) / TILE_ALIGN);
+	field->size = field->pitch * (th + 2 * field->hw);
+
+	if (field->hw > tw || field->hw > th) {
+		printf("Error: tiles (%i x %i) are narrower than the mask halo (%i).\n", tw, th, field->hw);
+		exit(-1);
+	}
+
+	if (posix_memalign(&data, 64, (size_t)field->ntx * field->nty * field->size * sizeof(fp_t))) {
+		printf("Error: unable to allocate %i x %i tiles.\n", field->ntx, field->nty);
+		exit(-1);
+	}
+	field->data = (fp_t*)data;
+	memset(field->data, 0, (size_t)field->ntx * field->nty * field->size * sizeof(fp_t));
+
+	field->order = (int*)malloc(field->ntx * field->nty * sizeof(int));
+	set_tile_order(field, TILE_ORDER_ROWS);
+	field->activity = NULL;
+}
+
+/**
+ \brief Tile number paired with its position along a space-filling curve
+*/
+struct TileKey {
+	long key;
+	int tile;
+};
+
+static int compare_tile_keys(const void* a, const void* b)
+{
+	const long ka = ((const struct TileKey*)a)->key;
+	const long kb = ((const struct TileKey*)b)->key;
+	return (ka > kb) - (ka < kb);
+}
+
+/**
+ \brief Position of (\a x, \a y) along the Morton curve: interleaved bits
+*/
+static long morton_index(const int x, const int y)
+{
+	long d = 0;
+	for (int b = 0; b < 16; b++) {
+		d |= (long)((x >> b) & 1) << (2 * b);
+		d |= (long)((y >> b) & 1) << (2 * b + 1);
+	}
+	return d;
+}
+
+/**
+ \brief Position of (\a x, \a y) along the Hilbert curve filling an \a n \f$\times\f$ \a n square
+
+ After the iterative xy2d algorithm, https://en.wikipedia.org/wiki/Hilbert_curve
+*/
+static long hilbert_index(const int n, int x, int y)
+{
+	long d = 0;
+	for (int s = n/2; s > 0; s /= 2) {
+		const int rx = (x & s) > 0;
+		const int ry = (y & s) > 0;
+		d += (long)s * s * ((3 * rx) ^ ry);
+
+		/* rotate the quadrant so the sub-curve has the canonical orientation */
+		if (ry == 0) {
+			if (rx == 1) {
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			const int t = x;
+			x = y;
+			y = t;
+		}
+	}
+	return d;
+}
+
+void set_tile_order(struct Tiles* field, const int curve)
+{
+	const int ntiles = field->ntx * field->nty;
+	struct TileKey* keys;
+	int n = 1;
+
+	while (n < field->ntx || n < field->nty)
+		n *= 2;
+
+	keys = (struct TileKey*)malloc(ntiles * sizeof(struct TileKey));
+	for (int tj = 0; tj < field->nty; tj++) {
+		for (int ti = 0; ti < field->ntx; ti++) {
+			const int tile = tj * field->ntx + ti;
+			keys[tile].tile = tile;
+			switch(curve) {
+				case TILE_ORDER_MORTON:
+					keys[tile].key = morton_index(ti, tj);
+					break;
+				case TILE_ORDER_HILBERT:
+					keys[tile].key = hilbert_index(n, ti, tj);
+					break;
+				default:
+					keys[tile].key = tile;
+			}
+		}
+	}
+
+	qsort(keys, ntiles, sizeof(struct TileKey), compare_tile_keys);
+	for (int k = 0; k < ntiles; k++)
+		field->order[k] = keys[k].tile;
+
+	field->curve = (curve == TILE_ORDER_MORTON || curve == TILE_ORDER_HILBERT) ? curve : TILE_ORDER_ROWS;
+	free(keys);
+}
+
+void free_tiles(struct Tiles* field)
+{
+	free(field->data);
+	field->data = NULL;
+
+	free(field->order);
+	field->order = NULL;
+}
+
+void swap_tiles(struct Tiles* conc_old, struct Tiles* conc_new)
+{
+	fp_t* temp;
+
+	temp = conc_old->data;
+	conc_old->data = conc_new->data;
+	conc_new->data = temp;
+}
+
+void refresh_tile_halo(struct Tiles* field, const int ti, const int tj)
+{
+	const int tw = field->tw;
+	const int th = field->th;
+	const int hw = field->hw;
+	const int pitch = field->pitch;
+	const unsigned long long start = trace_begin();
+	fp_t* tile = tile_origin(field, ti, tj);
+
+	/* visit the eight neighbors, copying the strip of each that overlaps our halo */
+	for (int dj = -1; dj < 2; dj++) {
+		for (int di = -1; di < 2; di++) {
+			if (di == 0 && dj == 0)
+				continue;
+			if (ti + di < 0 || ti + di >= field->ntx || tj + dj < 0 || tj + dj >= field->nty)
+				continue;
+
+			const fp_t* src = tile_origin(field, ti + di, tj + dj);
+
+			/* local range within our halo, and its offset in the neighbor */
+			const int x0 = (di < 0) ? -hw : (di > 0) ? tw : 0;
+			const int x1 = (di < 0) ?   0 : (di > 0) ? tw + hw : tw;
+			const int y0 = (dj < 0) ? -hw : (dj > 0) ? th : 0;
+			const int y1 = (dj < 0) ?   0 : (dj > 0) ? th + hw : th;
+			const int sx = x0 - di * tw;
+			const int sy = y0 - dj * th;
+
+			for (int y = y0; y < y1; y++)
+				memcpy(&tile[y * pitch + x0], &src[(sy + y - y0) * pitch + sx],
+				       (x1 - x0) * sizeof(fp_t));
+		}
+	}
+
+	trace_end("halo", tj * field->ntx + ti, start);
+}
+
+void convolve_tile(const struct Tiles* conc_old, struct Tiles* conc_lap,
+                   fp_t** const mask_lap, const int nm, const int ti, const int tj)
+{
+	const int pitch = conc_old->pitch;
+	const int i0 = ti * conc_old->tw;
+	const int j0 = tj * conc_old->th;
+	const int xlo = (i0 < nm/2) ? nm/2 - i0 : 0;
+	const int ylo = (j0 < nm/2) ? nm/2 - j0 : 0;
+	const int xhi = (i0 + conc_old->tw > conc_old->nx - nm/2) ? conc_old->nx - nm/2 - i0 : conc_old->tw;
+	const int yhi = (j0 + conc_old->th > conc_old->ny - nm/2) ? conc_old->ny - nm/2 - j0 : conc_old->th;
+	const unsigned long long start = trace_begin();
+	const fp_t* old = tile_origin(conc_old, ti, tj);
+	fp_t* lap = tile_origin(conc_lap, ti, tj);
+
+	for (int y = ylo; y < yhi; y++) {
+		for (int x = xlo; x < xhi; x++) {
+			fp_t value = 0.0;
+			for (int mj = -nm/2; mj < nm/2+1; mj++) {
+				for (int mi = -nm/2; mi < nm/2+1; mi++) {
+					value += mask_lap[mj+nm/2][mi+nm/2] * old[(y+mj) * pitch + x+mi];
+				}
+			}
+			lap[y * pitch + x] = value;
+		}
+	}
+
+	trace_end("convolution", tj * conc_old->ntx + ti, start);
+}
+
+void update_tile(const struct Tiles* conc_old, const struct Tiles* conc_lap,
+                 struct Tiles* conc_new, const int nm, const int ti, const int tj,
+                 const fp_t D, const fp_t dt)
+{
+	const int pitch = conc_old->pitch;
+	const int i0 = ti * conc_old->tw;
+	const int j0 = tj * conc_old->th;
+	const int xlo = (i0 < nm/2) ? nm/2 - i0 : 0;
+	const int ylo = (j0 < nm/2) ? nm/2 - j0 : 0;
+	const int xhi = (i0 + conc_old->tw > conc_old->nx - nm/2) ? conc_old->nx - nm/2 - i0 : conc_old->tw;
+	const int yhi = (j0 + conc_old->th > conc_old->ny - nm/2) ? conc_old->ny - nm/2 - j0 : conc_old->th;
+	const unsigned long long start = trace_begin();
+	const fp_t* old = tile_origin(conc_old, ti, tj);
+	const fp_t* lap = tile_origin(conc_lap, ti, tj);
+	fp_t* next = tile_origin(conc_new, ti, tj);
+
+	if (conc_old->activity == NULL) {
+		for (int y = ylo; y < yhi; y++) {
+			for (int x = xlo; x < xhi; x++) {
+				next[y * pitch + x] = old[y * pitch + x] + dt * D * lap[y * pitch + x];
+			}
+		}
+	} else {
+		fp_t change = 0.;
+		for (int y = ylo; y < yhi; y++) {
+			for (int x = xlo; x < xhi; x++) {
+				const fp_t delta = dt * D * lap[y * pitch + x];
+				next[y * pitch + x] = old[y * pitch + x] + delta;
+				change = fmax(change, fabs(delta));
+			}
+		}
+		conc_old->activity->change[tj * conc_old->ntx + ti] = change;
+	}
+
+	trace_end("update", tj * conc_old->ntx + ti, start);
+}
+
+void make_activity(struct Activity* act, const struct Tiles* field, const fp_t threshold)
+{
+	const int ntiles = field->ntx * field->nty;
+
+	act->ntx = field->ntx;
+	act->nty = field->nty;
+	act->threshold = threshold;
+	act->change = (fp_t*)malloc(ntiles * sizeof(fp_t));
+	act->active = (char*)calloc(ntiles, sizeof(char));
+	act->list = (int*)malloc(ntiles * sizeof(int));
+	act->nactive = 0;
+	act->swept = 0;
+	act->visited = 0;
+
+	/* nothing is known about the initial condition: wake every tile */
+	for (int k = 0; k < ntiles; k++) {
+		act->change[k] = INFINITY;
+		act->active[k] = 1;
+	}
+}
+
+void free_activity(struct Activity* act)
+{
+	free(act->change);
+	act->change = NULL;
+	free(act->active);
+	act->active = NULL;
+	free(act->list);
+	act->list = NULL;
+}
+
+/**
+ \brief Copy the interior of tile (\a ti, \a tj) from \a src to \a dst
+*/
+static void hold_tile(const struct Tiles* src, struct Tiles* dst, const int ti, const int tj)
+{
+	const fp_t* from = tile_origin(src, ti, tj);
+	fp_t* to = tile_origin(dst, ti, tj);
+
+	for (int y = 0; y < src->th; y++)
+		memcpy(&to[y * src->pitch], &from[y * src->pitch], src->tw * sizeof(fp_t));
+}
+
+void plan_activity(struct Activity* act, const struct Tiles* conc_old, struct Tiles* conc_new)
+{
+	const int ntx = act->ntx;
+	const int nty = act->nty;
+
+	act->nactive = 0;
+	for (int k = 0; k < ntx * nty; k++) {
+		const int ti = conc_old->order[k] % ntx;
+		const int tj = conc_old->order[k] / ntx;
+		char wake = 0;
+
+		for (int dj = -1; dj < 2 && !wake; dj++)
+			for (int di = -1; di < 2 && !wake; di++)
+				if (ti + di >= 0 && ti + di < ntx && tj + dj >= 0 && tj + dj < nty)
+					wake = act->change[(tj + dj) * ntx + ti + di] > act->threshold;
+
+		/* a tile going to sleep must leave identical values in both buffers */
+		if (!wake && act->active[conc_old->order[k]])
+			hold_tile(conc_old, conc_new, ti, tj);
+
+		act->active[conc_old->order[k]] = wake;
+		if (wake)
+			act->list[act->nactive++] = conc_old->order[k];
+	}
+
+	act->swept += act->nactive;
+	act->visited += ntx * nty;
+}
+
+fp_t activity_fraction(struct Activity* act)
+{
+	const fp_t fraction = (act->visited > 0) ? (fp_t)act->swept / act->visited : 1.;
+
+	act->swept = 0;
+	act->visited = 0;
+
+	return fraction;
+}
+
+void rowmajor_to_tiles(fp_t** conc, struct Tiles* field)
+{
+	for (int j = 0; j < field->ny; j++)
+		for (int i = 0; i < field->nx; i++)
+			*tiled_value(field, i, j) = conc[j][i];
+
+	for (int tj = 0; tj < field->nty; tj++)
+		for (int ti = 0; ti < field->ntx; ti++)
+			refresh_tile_halo(field, ti, tj);
+}
+
+void tiles_to_rowmajor(const struct Tiles* field, fp_t** conc)
+{
+	for (int j = 0; j < field->ny; j++)
+		for (int i = 0; i < field->nx; i++)
+			conc[j][i] = *tiled_value(field, i, j);
+}
@@ -0,0 +1,328 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  tiles.h
+ \brief Declaration of tiled (blocked) field layout for diffusion benchmarks
+*/
+
+/** \cond SuppressGuard */
+#ifndef _TILES_H_
+#define _TILES_H_
+/** \endcond */
+
+#include <stddef.h>
+#include "type.h"
+
+/**
+ \brief Number of field values per cache line, used to pad tile storage
+*/
+#define TILE_ALIGN (64 / (int)sizeof(fp_t))
+
+/**
+ \brief Visit tiles in row-major order of tile indices
+*/
+#define TILE_ORDER_ROWS 0
+
+/**
+ \brief Visit tiles along a Morton (Z-order) curve
+*/
+#define TILE_ORDER_MORTON 1
+
+/**
+ \brief Visit tiles along a Hilbert curve
+*/
+#define TILE_ORDER_HILBERT 2
+
+/**
+ \brief Which tiles of a field still evolve, so that sweeps may skip the rest
+
+ A tile is swept only if it, or one of its eight neighbors, changed by more
+ than \a threshold in the previous step: since the stencil reaches no further
+ than the halo, a tile whose whole neighborhood is steady cannot change
+ either, and wakes as soon as a neighbor's change exceeds \a threshold. With
+ \a threshold zero the skipped work is exactly zero; larger values freeze
+ tiles whose change per step is below it, trading a bounded error for
+ speed.
+*/
+struct Activity {
+	/**
+	 Number of tiles along \a x and \a y
+	*/
+	int ntx, nty;
+
+	/**
+	 Largest change per step that still counts as steady
+	*/
+	fp_t threshold;
+
+	/**
+	 Largest change of each tile in the last step it was swept
+	*/
+	fp_t* change;
+
+	/**
+	 Whether each tile is swept in the current step
+	*/
+	char* active;
+
+	/**
+	 Tiles swept in the current step, in the field's visiting order
+	*/
+	int* list;
+
+	/**
+	 Number of entries in \a list
+	*/
+	int nactive;
+
+	/**
+	 Tiles swept, and tiles in the mesh, summed over steps since the last
+	 call to activity_fraction()
+	*/
+	long swept, visited;
+};
+
+/**
+ \brief Scalar field stored as contiguous square tiles with halos
+
+ The mesh, including its boundary cells, is partitioned into \a tw
+ \f$\times\f$ \a th tiles. Each tile is stored contiguously, row-major, with
+ a halo of width \a hw on every side, and begins on a cache-line boundary.
+ Tiles are numbered row-major, \a i.e. tile (\a ti, \a tj) is the
+ (\a tj \f$\times\f$ \a ntx + \a ti)-th block of \a data. Stencil sweeps
+ touch only the owning tile, so a \f$ 3\times 3\f$ or \f$ 5\times 5\f$
+ stencil reads a few kB of nearby memory rather than \a nm distant rows.
+*/
+struct Tiles {
+	/**
+	 Mesh points along \a x and \a y, including boundary cells
+	*/
+	int nx, ny;
+
+	/**
+	 Interior width and height of each tile
+	*/
+	int tw, th;
+
+	/**
+	 Halo width, \a nm/2
+	*/
+	int hw;
+
+	/**
+	 Number of tiles along \a x and \a y
+	*/
+	int ntx, nty;
+
+	/**
+	 Row stride within a tile, padded to a multiple of #TILE_ALIGN
+	*/
+	int pitch;
+
+	/**
+	 Values per tile, including halo and padding
+	*/
+	int size;
+
+	/**
+	 Contiguous storage for all tiles
+	*/
+	fp_t* data;
+
+	/**
+	 Tile visiting order: the \a k-th tile swept is number \c order[k],
+	 \a i.e. tile (\c order[k] % \a ntx, \c order[k] / \a ntx)
+	*/
+	int* order;
+
+	/**
+	 Curve used to build \a order, one of TILE_ORDER_ROWS,
+	 TILE_ORDER_MORTON, or TILE_ORDER_HILBERT
+	*/
+	int curve;
+
+	/**
+	 Tiles to sweep, set on the \a conc_old field to skip steady tiles;
+	 \c NULL to sweep every tile
+	*/
+	struct Activity* activity;
+};
+
+/**
+ \brief Allocate tiled storage for an \a nx \f$\times\f$ \a ny field
+
+ Tiles are \a tw \f$\times\f$ \a th (typically \a bx \f$\times\f$ \a by from
+ the parameter file), with halos wide enough for an \a nm \f$\times\f$ \a nm
+ mask. Edge tiles are padded when \a nx or \a ny is not a multiple of the tile
+ size; padded cells are never read by the kernels.
+*/
+void make_tiles(struct Tiles* field, const int nx, const int ny,
+                const int tw, const int th, const int nm);
+
+/**
+ \brief Set the order in which threaded sweeps visit tiles
+
+ Along a space-filling curve, consecutive tiles are spatial neighbors, so
+ when each thread receives a contiguous chunk of \a order (\a e.g.
+ \c schedule(static) or \c tbb::static_partitioner), the tiles a thread
+ sweeps are compact and share halos, and tiles on neighboring threads sit
+ close together in the shared caches. Grids that are not square powers of
+ two are ordered by the curve over the enclosing power-of-two square.
+*/
+void set_tile_order(struct Tiles* field, const int curve);
+
+/**
+ \brief Free tiled storage
+*/
+void free_tiles(struct Tiles* field);
+
+/**
+ \brief Swap data pointers of two tiled fields with identical geometry
+*/
+void swap_tiles(struct Tiles* conc_old, struct Tiles* conc_new);
+
+/**
+ \brief Pointer to local cell (0, 0) of tile (\a ti, \a tj)
+
+ Local indices run from \a -hw to \a tw+hw-1 (\a x) and \a -hw to
+ \a th+hw-1 (\a y), so \c tile[y * pitch + x] addresses halo and interior
+ cells alike.
+*/
+static inline fp_t* tile_origin(const struct Tiles* field, const int ti, const int tj)
+{
+	return field->data + (tj * field->ntx + ti) * field->size
+	                   + field->hw * field->pitch + field->hw;
+}
+
+/**
+ \brief Pointer to the owned (interior) copy of global mesh point (\a i, \a j)
+
+ Intended for sparse access, such as boundary conditions, not for sweeps.
+*/
+static inline fp_t* tiled_value(const struct Tiles* field, const int i, const int j)
+{
+	const int ti = i / field->tw;
+	const int tj = j / field->th;
+	return tile_origin(field, ti, tj) + (j - tj * field->th) * field->pitch
+	                                  + (i - ti * field->tw);
+}
+
+/**
+ \brief Number of tiles the next sweep of \a field visits
+*/
+static inline int sweep_count(const struct Tiles* field)
+{
+	return (field->activity != NULL) ? field->activity->nactive : field->ntx * field->nty;
+}
+
+/**
+ \brief Number of the \a k-th tile the next sweep of \a field visits
+*/
+static inline int sweep_tile(const struct Tiles* field, const int k)
+{
+	return (field->activity != NULL) ? field->activity->list[k] : field->order[k];
+}
+
+/**
+ \brief Copy neighboring tile interiors into the halo of tile (\a ti, \a tj)
+
+ Must be called for every tile after the field has been modified and before
+ the next stencil sweep. Halo cells beyond the mesh are left untouched.
+*/
+void refresh_tile_halo(struct Tiles* field, const int ti, const int tj);
+
+/**
+ \brief Apply the convolution mask to the interior of tile (\a ti, \a tj)
+
+ Only mesh points with \f$ nm/2 \leq i < nx-nm/2 \f$ and
+ \f$ nm/2 \leq j < ny-nm/2 \f$ are computed, matching compute_convolution().
+*/
+void convolve_tile(const struct Tiles* conc_old, struct Tiles* conc_lap,
+                   fp_t** const mask_lap, const int nm, const int ti, const int tj);
+
+/**
+ \brief Forward-Euler update of the interior of tile (\a ti, \a tj)
+
+ If \a conc_old tracks activity, the largest change in the tile is recorded
+ for the next plan_activity().
+*/
+void update_tile(const struct Tiles* conc_old, const struct Tiles* conc_lap,
+                 struct Tiles* conc_new, const int nm, const int ti, const int tj,
+                 const fp_t D, const fp_t dt);
+
+/**
+ \brief Copy a row-major field into tiled storage, halos included
+*/
+void rowmajor_to_tiles(fp_t** conc, struct Tiles* field);
+
+/**
+ \brief Copy tiled storage into a row-major field
+
+ Used at checkpoints, so that write_png(), write_csv(), and check_solution()
+ operate on the familiar \c fp_t** layout.
+*/
+void tiles_to_rowmajor(const struct Tiles* field, fp_t** conc);
+
+/**
+ \brief Track activity of \a field, marking every tile active for the first step
+*/
+void make_activity(struct Activity* act, const struct Tiles* field, const fp_t threshold);
+
+/**
+ \brief Free activity map
+*/
+void free_activity(struct Activity* act);
+
+/**
+ \brief Choose the tiles to sweep this step from the changes recorded in the last
+
+ Tiles leaving the active set have their interior copied from \a conc_old to
+ \a conc_new, so that both buffers hold the frozen values while the tile is
+ skipped and swapping them changes nothing.
+*/
+void plan_activity(struct Activity* act, const struct Tiles* conc_old, struct Tiles* conc_new);
+
+/**
+ \brief Mean fraction of tiles swept per step since the last call, which resets it
+*/
+fp_t activity_fraction(struct Activity* act);
+
+/* The following are implemented by each CPU backend, alongside their
+   row-major counterparts in boundaries.h and numerics.h. */
+
+/**
+ \brief Initialize tiled composition field, as apply_initial_conditions()
+*/
+void apply_initial_conditions_tiled(struct Tiles* conc, const int nm);
+
+/**
+ \brief Apply boundary conditions to tiled field, then refresh every halo
+
+ Equivalent to apply_boundary_conditions() followed by refresh_tile_halo()
+ on every tile the next sweep visits, leaving the field ready for a stencil
+ sweep.
+*/
+void apply_boundary_conditions_tiled(struct Tiles* conc, const int nm);
+
+/**
+ \brief Tiled equivalent of compute_convolution()
+
+ Visits the sweep_count() tiles given by sweep_tile(), \a i.e. only active
+ tiles when \a conc_old tracks activity.
+*/
+void compute_convolution_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                               fp_t** const mask_lap, const int nm);
+
+/**
+ \brief Tiled equivalent of update_composition()
+*/
+void update_composition_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                              struct Tiles* conc_new, const int nm,
+                              const fp_t D, const fp_t dt);
+
+/** \cond SuppressGuard */
+#endif /* _TILES_H_ */
+/** \endcond */
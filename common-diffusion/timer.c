@@ -24,60 +24,233 @@
  * 12 August 2017: report time in seconds, not milliseconds
  * 24 August 2017: include header file defining functions
  * 13 September 2017: define __USE_BSD to provide timersub, which is non-POSIX
+ * 18 October 2026: replace gettimeofday with CLOCK_MONOTONIC_RAW or calibrated
+ *                  TSC; add nested named scopes with per-thread accumulators
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "timer.h"
 
 #ifdef WIN32
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
+	#define TIMER_LOCAL __declspec(thread)
 #else
-	#ifndef __USE_BSD
-		#define __USE_BSD
+	#include <time.h>
+	#if defined(TIMER_TSC) && (defined(__x86_64__) || defined(__i386__))
+		#include <x86intrin.h>
 	#endif
-	#ifndef __USE_MISC
-		#define __USE_MISC
+	#ifndef CLOCK_MONOTONIC_RAW
+		#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
 	#endif
-	#include <sys/time.h>
+	#define TIMER_LOCAL __thread
 #endif
 
 /**
- Platform-dependent data type of hardware time value
+ Clock reading at StartTimer(), and seconds per tick
 */
+unsigned long long timerStart = 0;
+double timerTick = 1.0e-9;
+
+/**
+ \brief Node in the tree of scopes: a name and the index of its parent
+*/
+struct TimerScope {
+	const char* name;
+	int parent;
+};
+
+/**
+ \brief Accumulators and open-scope stack belonging to one thread
+*/
+struct TimerThread {
+	unsigned long long ticks[TIMER_MAX_SCOPES];
+	long calls[TIMER_MAX_SCOPES];
+	unsigned long long start[TIMER_MAX_DEPTH];
+	int stack[TIMER_MAX_DEPTH];
+	int depth;
+};
+
+static struct TimerScope timer_scopes[TIMER_MAX_SCOPES];
+static volatile int timer_nscopes = 0;
+static struct TimerThread* timer_threads[TIMER_MAX_THREADS];
+static volatile int timer_nthreads = 0;
+static volatile int timer_lock = 0;
+static TIMER_LOCAL struct TimerThread* timer_self = NULL;
+
+#ifndef WIN32
+static unsigned long long monotonic_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+}
+#endif
+
+unsigned long long TimerTicks()
+{
 #ifdef WIN32
-double PCFreq = 0.0;
-__int64 timerStart = 0;
+	LARGE_INTEGER li;
+	QueryPerformanceCounter(&li);
+	return li.QuadPart;
+#elif defined(TIMER_TSC) && (defined(__x86_64__) || defined(__i386__))
+	return __rdtsc();
 #else
-struct timeval timerStart;
+	return monotonic_ns();
 #endif
+}
+
+double TimerResolution()
+{
+	return timerTick;
+}
 
 void StartTimer()
 {
 #ifdef WIN32
-    LARGE_INTEGER li;
-    if(!QueryPerformanceFrequency(&li))
-        printf("QueryPerformanceFrequency failed!\n");
-
-    PCFreq = (double)li.QuadPart/1000000.0;
-
-    QueryPerformanceCounter(&li);
-    timerStart = li.QuadPart;
+	LARGE_INTEGER li;
+	if(!QueryPerformanceFrequency(&li))
+		printf("QueryPerformanceFrequency failed!\n");
+	timerTick = 1.0 / (double)li.QuadPart;
+#elif defined(TIMER_TSC) && (defined(__x86_64__) || defined(__i386__))
+	/* calibrate the TSC against the monotonic clock over 5 ms */
+	const unsigned long long ns0 = monotonic_ns();
+	const unsigned long long tsc0 = __rdtsc();
+	while (monotonic_ns() - ns0 < 5000000ULL);
+	const unsigned long long ns1 = monotonic_ns();
+	const unsigned long long tsc1 = __rdtsc();
+	timerTick = 1.0e-9 * (double)(ns1 - ns0) / (double)(tsc1 - tsc0);
 #else
-    gettimeofday(&timerStart, NULL);
+	timerTick = 1.0e-9;
 #endif
+	timerStart = TimerTicks();
 }
 
 double GetTimer()
 {
-#ifdef WIN32
-    LARGE_INTEGER li;
-    QueryPerformanceCounter(&li);
-    return (double)(li.QuadPart-timerStart)/PCFreq;
-#else
-    struct timeval timerStop, timerElapsed;
-    gettimeofday(&timerStop, NULL);
-    timersub(&timerStop, &timerStart, &timerElapsed);
-    return timerElapsed.tv_sec+timerElapsed.tv_usec/1000000.0;
-#endif
+	return timerTick * (double)(TimerTicks() - timerStart);
+}
+
+static void acquire_timer_lock()
+{
+	while (__sync_lock_test_and_set(&timer_lock, 1))
+		while (timer_lock);
+}
+
+static void release_timer_lock()
+{
+	__sync_lock_release(&timer_lock);
+}
+
+/**
+ \brief Index of scope (\a name, \a parent), registering it if new
+*/
+static int find_scope(const char* name, const int parent)
+{
+	int n = timer_nscopes;
+
+	for (int s = 0; s < n; s++)
+		if (timer_scopes[s].parent == parent && (timer_scopes[s].name == name || strcmp(timer_scopes[s].name, name) == 0))
+			return s;
+
+	acquire_timer_lock();
+	for (int s = n; s < timer_nscopes; s++) {
+		if (timer_scopes[s].parent == parent && strcmp(timer_scopes[s].name, name) == 0) {
+			release_timer_lock();
+			return s;
+		}
+	}
+	if (timer_nscopes == TIMER_MAX_SCOPES) {
+		printf("Error: more than %i timer scopes.\n", TIMER_MAX_SCOPES);
+		exit(-1);
+	}
+	n = timer_nscopes;
+	timer_scopes[n].name = name;
+	timer_scopes[n].parent = parent;
+	__sync_synchronize();
+	timer_nscopes = n + 1;
+	release_timer_lock();
+
+	return n;
+}
+
+void timer_push(const char* name)
+{
+	struct TimerThread* self = timer_self;
+
+	if (self == NULL) {
+		self = (struct TimerThread*)calloc(1, sizeof(struct TimerThread));
+		acquire_timer_lock();
+		if (timer_nthreads == TIMER_MAX_THREADS) {
+			printf("Error: more than %i threads using timer scopes.\n", TIMER_MAX_THREADS);
+			exit(-1);
+		}
+		timer_threads[timer_nthreads++] = self;
+		release_timer_lock();
+		timer_self = self;
+	}
+
+	if (self->depth == TIMER_MAX_DEPTH) {
+		printf("Error: timer scopes nested deeper than %i.\n", TIMER_MAX_DEPTH);
+		exit(-1);
+	}
+
+	self->stack[self->depth] = find_scope(name, (self->depth > 0) ? self->stack[self->depth - 1] : -1);
+	self->start[self->depth] = TimerTicks();
+	self->depth++;
+}
+
+double timer_pop()
+{
+	const unsigned long long stop = TimerTicks();
+	struct TimerThread* self = timer_self;
+
+	if (self == NULL || self->depth == 0) {
+		printf("Error: timer_pop() without matching timer_push().\n");
+		exit(-1);
+	}
+
+	self->depth--;
+	const int s = self->stack[self->depth];
+	const unsigned long long ticks = stop - self->start[self->depth];
+	self->ticks[s] += ticks;
+	self->calls[s]++;
+
+	return timerTick * (double)ticks;
+}
+
+/**
+ \brief Print scope \a s and its descendants, indented by \a level
+*/
+static void report_scope(FILE* output, const int s, const int level)
+{
+	unsigned long long total = 0, most = 0;
+	long calls = 0;
+
+	for (int t = 0; t < timer_nthreads; t++) {
+		total += timer_threads[t]->ticks[s];
+		calls += timer_threads[t]->calls[s];
+		if (timer_threads[t]->ticks[s] > most)
+			most = timer_threads[t]->ticks[s];
+	}
+
+	fprintf(output, "%*s%-*s %10li %12.6f %12.6f\n", 2 * level, "", 24 - 2 * level,
+	        timer_scopes[s].name, calls, timerTick * total, timerTick * most);
+
+	for (int c = s + 1; c < timer_nscopes; c++)
+		if (timer_scopes[c].parent == s)
+			report_scope(output, c, level + 1);
+}
+
+void timer_report(FILE* output)
+{
+	if (timer_nscopes == 0)
+		return;
+
+	fprintf(output, "%-24s %10s %12s %12s\n", "scope", "calls", "total (s)", "thread max");
+	for (int s = 0; s < timer_nscopes; s++)
+		if (timer_scopes[s].parent < 0)
+			report_scope(output, s, 0);
 }
@@ -0,0 +1,166 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  trace.c
+ \brief Implementation of per-thread event tracing in Chrome trace format
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ \brief Completed event, timestamped in clock ticks
+*/
+struct TraceEvent {
+	unsigned long long start, stop;
+	const char* name;
+	int arg;
+};
+
+/**
+ \brief Ring buffer of one thread's events, padded to a cache line
+*/
+struct TraceRing {
+	struct TraceEvent* events;
+	long count;
+	char pad[64 - sizeof(struct TraceEvent*) - sizeof(long)];
+};
+
+static struct TraceRing trace_rings[TRACE_MAX_THREADS];
+static int trace_capacity = 0;
+static int trace_threads = 0;
+static unsigned long long trace_tick0 = 0;
+static double trace_time0 = 0.;
+
+/**
+ \brief Ring buffer index of the calling thread, assigned on its first event
+*/
+static __thread int trace_slot = -1;
+
+static unsigned long long trace_clock(void)
+{
+	#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+	#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+	#endif
+}
+
+static double trace_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+}
+
+void open_trace(const int capacity)
+{
+	if (capacity < 1)
+		return;
+
+	trace_capacity = capacity;
+	trace_threads = 0;
+	trace_slot = -1;
+	trace_tick0 = trace_clock();
+	trace_time0 = trace_seconds();
+}
+
+unsigned long long trace_begin(void)
+{
+	return (trace_capacity > 0) ? trace_clock() : 0;
+}
+
+void trace_end(const char* name, const int arg, const unsigned long long start)
+{
+	struct TraceRing* ring;
+	struct TraceEvent* event;
+
+	if (trace_capacity < 1)
+		return;
+
+	if (trace_slot < 0) {
+		trace_slot = __sync_fetch_and_add(&trace_threads, 1);
+		if (trace_slot < TRACE_MAX_THREADS)
+			trace_rings[trace_slot].events = (struct TraceEvent*)malloc(trace_capacity * sizeof(struct TraceEvent));
+	}
+	if (trace_slot >= TRACE_MAX_THREADS || trace_rings[trace_slot].events == NULL)
+		return;
+
+	ring = &trace_rings[trace_slot];
+	event = &ring->events[ring->count % trace_capacity];
+	event->start = start;
+	event->stop = trace_clock();
+	event->name = name;
+	event->arg = arg;
+	ring->count++;
+}
+
+void write_trace(const char* filename)
+{
+	FILE* output;
+	const char* sep = "";
+	const int nthreads = (trace_threads < TRACE_MAX_THREADS) ? trace_threads : TRACE_MAX_THREADS;
+
+	if (trace_capacity < 1)
+		return;
+
+	/* calibrate clock ticks against the monotonic clock over the whole run */
+	const double elapsed = trace_seconds() - trace_time0;
+	const double ticks = (double)(trace_clock() - trace_tick0);
+	const double us_per_tick = (ticks > 0.) ? 1.e6 * elapsed / ticks : 0.;
+
+	output = fopen(filename, "w");
+	if (output == NULL) {
+		printf("Error: unable to open %s for output. Check permissions.\n", filename);
+		exit(-1);
+	}
+
+	fprintf(output, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	for (int t = 0; t < nthreads; t++) {
+		const struct TraceRing* ring = &trace_rings[t];
+		const long first = (ring->count > trace_capacity) ? ring->count - trace_capacity : 0;
+
+		fprintf(output, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %i, "
+		        "\"args\": {\"name\": \"thread %i\"}}", sep, t, t);
+		sep = ",";
+
+		if (ring->events == NULL)
+			continue;
+
+		for (long n = first; n < ring->count; n++) {
+			const struct TraceEvent* event = &ring->events[n % trace_capacity];
+			fprintf(output, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %i, "
+			        "\"ts\": %.3f, \"dur\": %.3f", event->name, t,
+			        us_per_tick * (double)(event->start - trace_tick0),
+			        us_per_tick * (double)(event->stop - event->start));
+			if (event->arg >= 0)
+				fprintf(output, ", \"args\": {\"tile\": %i}", event->arg);
+			fprintf(output, "}");
+		}
+	}
+	fprintf(output, "\n]}\n");
+
+	fclose(output);
+}
+
+void close_trace(void)
+{
+	for (int t = 0; t < TRACE_MAX_THREADS; t++) {
+		free(trace_rings[t].events);
+		trace_rings[t].events = NULL;
+		trace_rings[t].count = 0;
+	}
+	trace_capacity = 0;
+	trace_threads = 0;
+}
@@ -0,0 +1,63 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  trace.h
+ \brief Declaration of per-thread event tracing in Chrome trace format
+*/
+
+/** \cond SuppressGuard */
+#ifndef _TRACE_H_
+#define _TRACE_H_
+/** \endcond */
+
+/**
+ \brief Largest number of threads whose events are recorded
+*/
+#define TRACE_MAX_THREADS 256
+
+/**
+ \brief Enable tracing, keeping the latest \a capacity events of each thread
+
+ Each thread records into its own ring buffer, allocated on its first event,
+ so recording takes no locks and older events are overwritten: a long run
+ keeps a window of the final steps. Zero \a capacity leaves tracing
+ disabled, reducing trace_begin() and trace_end() to a single branch.
+*/
+void open_trace(const int capacity);
+
+/**
+ \brief Timestamp marking the beginning of a traced event
+
+ Reads the time-stamp counter on x86, or the monotonic clock elsewhere.
+ Returns zero when tracing is disabled.
+*/
+unsigned long long trace_begin(void);
+
+/**
+ \brief Record event \a name, begun at \a start, on the calling thread
+
+ \a name must be a string literal or otherwise outlive the trace. \a arg is
+ reported as the event's \a tile argument (\a e.g. tile number); negative
+ values are omitted.
+*/
+void trace_end(const char* name, const int arg, const unsigned long long start);
+
+/**
+ \brief Write recorded events to \a filename as Chrome trace JSON
+
+ Load the file in \c chrome://tracing or https://ui.perfetto.dev to see
+ each thread's timeline. Does nothing when tracing is disabled.
+*/
+void write_trace(const char* filename);
+
+/**
+ \brief Free trace buffers and disable tracing
+*/
+void close_trace(void);
+
+/** \cond SuppressGuard */
+#endif /* _TRACE_H_ */
+/** \endcond */
@@ -21,6 +21,18 @@
 */
 typedef double fp_t;
 
+/**
+ Number of kernel phases instrumented with hardware counters: convolution,
+ update, boundary conditions, and analytical solution, in that order
+*/
+#define NUM_PHASES 4
+
+/**
+ Number of hardware events counted per phase: cycles, instructions,
+ last-level cache misses, and stalled cycles, in that order
+*/
+#define NUM_EVENTS 4
+
 /**
  Container for timing data
 */
@@ -44,6 +56,12 @@ struct Stopwatch {
 	 Cumulative time executing check_solution()
 	*/
 	fp_t soln;
+
+	/**
+	 Cumulative hardware event counts per phase, from read_counters();
+	 -1 where an event is unavailable
+	*/
+	long long events[NUM_PHASES][NUM_EVENTS];
 };
 
 /** \cond SuppressGuard */
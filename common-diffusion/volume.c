@@ -0,0 +1,249 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  volume.c
+ \brief Implementation of three-dimensional fields, stencils, and analytical solution
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numerics.h"
+#include "volume.h"
+
+/**
+ \brief Allocate one 3D field: contiguous data, with row and plane pointers mapped onto it
+*/
+static fp_t*** make_volume(const int nx, const int ny, const int nz)
+{
+	fp_t*** field = (fp_t***)calloc(nz, sizeof(fp_t**));
+	fp_t** rows = (fp_t**)calloc(nz * ny, sizeof(fp_t*));
+	fp_t* data = (fp_t*)calloc((size_t)nx * ny * nz, sizeof(fp_t));
+
+	if (field == NULL || rows == NULL || data == NULL) {
+		printf("Error: unable to allocate %i x %i x %i field.\n", nx, ny, nz);
+		exit(-1);
+	}
+
+	for (int j = 0; j < nz * ny; j++)
+		rows[j] = &data[(size_t)nx * j];
+
+	for (int k = 0; k < nz; k++)
+		field[k] = &rows[ny * k];
+
+	return field;
+}
+
+/**
+ \brief Free one field from make_volume()
+*/
+static void free_volume(fp_t*** field)
+{
+	free(field[0][0]);
+	free(field[0]);
+	free(field);
+}
+
+void make_arrays_3d(fp_t**** conc_old, fp_t**** conc_new, fp_t**** conc_lap, fp_t**** mask_lap,
+                    const int nx, const int ny, const int nz, const int nm)
+{
+	*conc_old = make_volume(nx, ny, nz);
+	*conc_new = make_volume(nx, ny, nz);
+	*conc_lap = make_volume(nx, ny, nz);
+	*mask_lap = make_volume(nm, nm, nm);
+}
+
+void free_arrays_3d(fp_t*** conc_old, fp_t*** conc_new, fp_t*** conc_lap, fp_t*** mask_lap)
+{
+	free_volume(conc_old);
+	free_volume(conc_new);
+	free_volume(conc_lap);
+	free_volume(mask_lap);
+}
+
+void swap_pointers_3d(fp_t**** conc_old, fp_t**** conc_new)
+{
+	fp_t*** temp;
+
+	temp = (*conc_old);
+	(*conc_old) = (*conc_new);
+	(*conc_new) = temp;
+}
+
+void set_mask_3d(const fp_t dx, const fp_t dy, const fp_t dz, const int code,
+                 fp_t*** mask_lap, const int nm)
+{
+	if (nm != MAX_MASK_D) {
+		printf("Error: 3D stencils need mask size %i, not %i.\n", MAX_MASK_D, nm);
+		exit(-1);
+	}
+
+	switch(code) {
+		case 73:
+			seven_point_Laplacian_stencil(dx, dy, dz, mask_lap, nm);
+			break;
+		case 273:
+			twenty_seven_point_Laplacian_stencil(dx, dy, dz, mask_lap, nm);
+			break;
+		default :
+			seven_point_Laplacian_stencil(dx, dy, dz, mask_lap, nm);
+	}
+}
+
+void seven_point_Laplacian_stencil(const fp_t dx, const fp_t dy, const fp_t dz,
+                                   fp_t*** mask_lap, const int nm)
+{
+	mask_lap[0][1][1] =  1. / (dz * dz); /* back */
+	mask_lap[1][0][1] =  1. / (dy * dy); /* upper */
+	mask_lap[1][1][0] =  1. / (dx * dx); /* left */
+	mask_lap[1][1][1] = -2. * (1. / (dx * dx) + 1. / (dy * dy) + 1. / (dz * dz)); /* middle */
+	mask_lap[1][1][2] =  1. / (dx * dx); /* right */
+	mask_lap[1][2][1] =  1. / (dy * dy); /* lower */
+	mask_lap[2][1][1] =  1. / (dz * dz); /* front */
+}
+
+void twenty_seven_point_Laplacian_stencil(const fp_t dx, const fp_t dy, const fp_t dz,
+                                          fp_t*** mask_lap, const int nm)
+{
+	const fp_t d[3] = {dx, dy, dz};
+	fp_t center = 0.;
+
+	for (int mk = 0; mk < 3; mk++) {
+		for (int mj = 0; mj < 3; mj++) {
+			for (int mi = 0; mi < 3; mi++) {
+				const int off[3] = {mi != 1, mj != 1, mk != 1};
+				const int n = off[0] + off[1] + off[2];
+				fp_t area = 1.;
+				fp_t w = 0.;
+
+				/* product of the squared spacings along the offset axes; its roots
+				   below are their geometric means */
+				for (int a = 0; a < 3; a++)
+					if (off[a])
+						area *= d[a] * d[a];
+
+				if (n == 1)
+					w = 7. / (15. * area); /* face */
+				else if (n == 2)
+					w = 1. / (10. * sqrt(area)); /* edge */
+				else if (n == 3)
+					w = 1. / (30. * cbrt(area)); /* corner */
+
+				mask_lap[mk][mj][mi] = w;
+				center -= w;
+			}
+		}
+	}
+
+	mask_lap[1][1][1] = center; /* middle */
+}
+
+fp_t distance_point_to_rectangle(const fp_t ax, const fp_t ay0, const fp_t ay1,
+                                 const fp_t az0, const fp_t az1,
+                                 const fp_t px, const fp_t py, const fp_t pz)
+{
+	const fp_t zy = fmax(ay0, fmin(ay1, py));
+	const fp_t zz = fmax(az0, fmin(az1, pz));
+	return sqrt((px - ax) * (px - ax) + (py - zy) * (py - zy) + (pz - zz) * (pz - zz));
+}
+
+void check_solution_3d(fp_t*** conc_new, fp_t*** conc_lap,
+                       const int nx, const int ny, const int nz,
+                       const fp_t dx, const fp_t dy, const fp_t dz, const int nm,
+                       const fp_t elapsed, const fp_t D, fp_t* rss)
+{
+	const fp_t cells = (fp_t)(nx-1-nm/2) * (ny-1-nm/2) * (nz-1-nm/2);
+	fp_t sum = 0.;
+
+	#ifdef _OPENMP
+	#pragma omp parallel for reduction(+:sum) schedule(static)
+	#endif
+	for (int k = nm/2; k < nz-nm/2; k++) {
+		for (int j = nm/2; j < ny-nm/2; j++) {
+			for (int i = nm/2; i < nx-nm/2; i++) {
+				fp_t cal, car, r;
+
+				/* numerical solution */
+				const fp_t cn = conc_new[k][j][i];
+
+				/* shortest distance to left-wall source */
+				r = distance_point_to_rectangle(dx * (nm/2),
+				                                dy * (nm/2), dy * (ny/2),
+				                                dz * (nm/2), dz * (nz/2),
+				                                dx * i, dy * j, dz * k);
+				analytical_value(r, elapsed, D, &cal);
+
+				/* shortest distance to right-wall source */
+				r = distance_point_to_rectangle(dx * (nx-1-nm/2),
+				                                dy * (ny/2), dy * (ny-1-nm/2),
+				                                dz * (nz/2), dz * (nz-1-nm/2),
+				                                dx * i, dy * j, dz * k);
+				analytical_value(r, elapsed, D, &car);
+
+				/* superposition of analytical solutions */
+				const fp_t ca = cal + car;
+
+				/* residual sum of squares (RSS) */
+				conc_lap[k][j][i] = (ca - cn) * (ca - cn) / cells;
+				sum += conc_lap[k][j][i];
+			}
+		}
+	}
+
+	*rss = sum;
+}
+
+int column_buffer_size(const int bx, const int by, const int nm)
+{
+	return nm * (bx + 2 * (nm/2)) * (by + 2 * (nm/2));
+}
+
+void convolve_column(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                     const int nz, const int nm,
+                     const int x0, const int x1, const int y0, const int y1,
+                     fp_t* queue)
+{
+	const int h = nm/2;
+	const int pw = x1 - x0 + 2 * h;
+	const int ph = y1 - y0 + 2 * h;
+	const int plane = pw * ph;
+
+	/* fill the queue with every plane but the last one the first sweep needs */
+	for (int k = 0; k < nm - 1; k++) {
+		fp_t* slot = &queue[(k % nm) * plane];
+		for (int y = 0; y < ph; y++)
+			memcpy(&slot[y * pw], &conc_old[k][y0 - h + y][x0 - h], pw * sizeof(fp_t));
+	}
+
+	for (int k = h; k < nz - h; k++) {
+		/* load plane k + h over the slot of plane k - h - 1 */
+		fp_t* slot = &queue[((k + h) % nm) * plane];
+		for (int y = 0; y < ph; y++)
+			memcpy(&slot[y * pw], &conc_old[k + h][y0 - h + y][x0 - h], pw * sizeof(fp_t));
+
+		/* the queue is in cache, so sweep it once per mask entry with unit
+		   stride, skipping the zeros of sparse masks such as the seven-point */
+		for (int y = 0; y < y1 - y0; y++) {
+			fp_t* out = &conc_lap[k][y0 + y][x0];
+			for (int x = 0; x < x1 - x0; x++)
+				out[x] = 0.0;
+			for (int mk = 0; mk < nm; mk++) {
+				const fp_t* src = &queue[((k - h + mk) % nm) * plane];
+				for (int mj = 0; mj < nm; mj++) {
+					for (int mi = 0; mi < nm; mi++) {
+						const fp_t weight = mask_lap[mk][mj][mi];
+						const fp_t* row = &src[(y + mj) * pw + mi];
+						if (weight == 0.0)
+							continue;
+						for (int x = 0; x < x1 - x0; x++)
+							out[x] += weight * row[x];
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,168 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  volume.h
+ \brief Declaration of three-dimensional fields, stencils, and analytical solution for diffusion benchmarks
+*/
+
+/** \cond SuppressGuard */
+#ifndef _VOLUME_H_
+#define _VOLUME_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief Maximum depth of the three-dimensional convolution mask
+*/
+#define MAX_MASK_D 3
+
+/**
+ \brief Allocate 3D arrays to store scalar composition values
+
+ As make_arrays(), one 1D block per field with pointers mapped over it, so
+ that \c conc[k][j][i] addresses mesh point (\a i, \a j, \a k) and each
+ plane \c conc[k] is itself an \a nx \f$\times\f$ \a ny \c fp_t** field,
+ ready for write_png() or write_csv(). The mask is \a nm \f$\times\f$ \a nm
+ \f$\times\f$ \a nm.
+*/
+void make_arrays_3d(fp_t**** conc_old, fp_t**** conc_new, fp_t**** conc_lap, fp_t**** mask_lap,
+                    const int nx, const int ny, const int nz, const int nm);
+
+/**
+ \brief Free arrays from make_arrays_3d()
+*/
+void free_arrays_3d(fp_t*** conc_old, fp_t*** conc_new, fp_t*** conc_lap, fp_t*** mask_lap);
+
+/**
+ \brief Swap pointers to 3D arrays, as swap_pointers()
+*/
+void swap_pointers_3d(fp_t**** conc_old, fp_t**** conc_new);
+
+/**
+ \brief Specify which stencil (mask) to use for the 3D Laplacian
+
+ Codes follow set_mask(): 73 specifies seven_point_Laplacian_stencil() and
+ 273 specifies twenty_seven_point_Laplacian_stencil(). Unknown codes fall
+ back to the seven-point stencil.
+*/
+void set_mask_3d(const fp_t dx, const fp_t dy, const fp_t dz, const int code,
+                 fp_t*** mask_lap, const int nm);
+
+/**
+ \brief Write 7-point Laplacian stencil into convolution mask
+
+ \f$3\times3\times3\f$ mask, 7 values, truncation error \f$\mathcal{O}(\Delta x^2)\f$
+*/
+void seven_point_Laplacian_stencil(const fp_t dx, const fp_t dy, const fp_t dz,
+                                   fp_t*** mask_lap, const int nm);
+
+/**
+ \brief Write 27-point Laplacian stencil into convolution mask
+
+ \f$3\times3\times3\f$ mask, 27 values: faces \f$ 7/15\f$, edges \f$ 1/10\f$,
+ and corners \f$ 1/30\f$ of \f$ 1/\Delta x^2\f$, after Patra and Karttunen
+ (2006). Truncation error is \f$\mathcal{O}(\Delta x^2)\f$, as for the
+ seven-point stencil, but its leading term is isotropic, so fronts do not
+ drift toward the mesh axes. Like nine_point_Laplacian_stencil(), intended for
+ \f$\Delta x = \Delta y = \Delta z\f$; products of spacings scale the
+ off-axis weights otherwise, with the center weight balancing the rest.
+*/
+void twenty_seven_point_Laplacian_stencil(const fp_t dx, const fp_t dy, const fp_t dz,
+                                          fp_t*** mask_lap, const int nm);
+
+/**
+ \brief Compute minimum distance from point \a p to an axis-aligned rectangle in the plane \a x = \a ax
+
+ The rectangle spans [\a ay0, \a ay1] \f$\times\f$ [\a az0, \a az1]; this is
+ the 3D counterpart of distance_point_to_segment().
+*/
+fp_t distance_point_to_rectangle(const fp_t ax, const fp_t ay0, const fp_t ay1,
+                                 const fp_t az0, const fp_t az1,
+                                 const fp_t px, const fp_t py, const fp_t pz);
+
+/**
+ \brief Compare numerical and analytical solutions of the 3D diffusion equation
+
+ The sources are the two fixed-value patches set by
+ apply_initial_conditions_3d(): a quarter of the left face (\a y and \a z
+ below the midplanes) and the diagonally opposite quarter of the right face.
+ Each contributes analytical_value() at the shortest distance to its patch,
+ and their superposition is compared with \a conc_new, as check_solution().
+ Overwrites \a conc_lap.
+*/
+void check_solution_3d(fp_t*** conc_new, fp_t*** conc_lap,
+                       const int nx, const int ny, const int nz,
+                       const fp_t dx, const fp_t dy, const fp_t dz, const int nm,
+                       const fp_t elapsed, const fp_t D, fp_t* rss);
+
+/**
+ \brief Number of values in the plane queue used by convolve_column()
+*/
+int column_buffer_size(const int bx, const int by, const int nm);
+
+/**
+ \brief Convolve one \a xy tile through the full depth of the field, streaming along \a z
+
+ The tile covers [\a x0, \a x1) \f$\times\f$ [\a y0, \a y1) of the interior.
+ \a queue holds column_buffer_size() values: \a nm slots, each a compact copy
+ of one plane of the tile plus its halo, so that plane \a k sits in slot
+ \a k \% \a nm. Computing plane \a k loads only plane \a k + \a nm/2, over
+ the slot of the plane no longer needed; the stencil then reads only the
+ queue. Each thread must pass its own \a queue.
+*/
+void convolve_column(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                     const int nz, const int nm,
+                     const int x0, const int x1, const int y0, const int y1,
+                     fp_t* queue);
+
+/* The following are implemented by each CPU backend, alongside their
+   2D counterparts in boundaries.h and numerics.h. */
+
+/**
+ \brief Initialize 3D composition field: zero, with two fixed-value patches
+
+ Cells with \f$ i < 1 + nm/2\f$, \f$ j < ny/2\f$, \f$ k < nz/2\f$ and with
+ \f$ i \geq nx-1-nm/2\f$, \f$ j \geq ny/2\f$, \f$ k \geq nz/2\f$ are set
+ to 1, the 3D analog of apply_initial_conditions().
+*/
+void apply_initial_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm);
+
+/**
+ \brief Reset the fixed-value patches, then apply no-flux conditions along \a x, \a y, and \a z
+*/
+void apply_boundary_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm);
+
+/**
+ \brief Apply the 3D convolution mask to the interior, as compute_convolution()
+*/
+void compute_convolution_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                            const int nx, const int ny, const int nz, const int nm);
+
+/**
+ \brief 2.5D-blocked equivalent of compute_convolution_3d()
+
+ The \a xy plane is cut into \a bx \f$\times\f$ \a by tiles. Each tile
+ streams along \a z through a queue of \a nm planes, each a compact copy of
+ the tile and its halo: advancing one plane loads one new plane and
+ discards the oldest, so every value is read from the field once per tile
+ and the stencil works entirely within a few kB that stay in cache, however
+ large the planes are.
+*/
+void compute_convolution_3d_blocked(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                                    const int nx, const int ny, const int nz, const int nm,
+                                    const int bx, const int by);
+
+/**
+ \brief Update 3D composition field using explicit Euler discretization, as update_composition()
+*/
+void update_composition_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** conc_new,
+                           const int nx, const int ny, const int nz, const int nm,
+                           const fp_t D, const fp_t dt);
+
+/** \cond SuppressGuard */
+#endif /* _VOLUME_H_ */
+/** \endcond */
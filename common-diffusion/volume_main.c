@@ -0,0 +1,140 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  volume_main.c
+ \brief Three-dimensional implementation of semi-infinite diffusion equation, shared by the CPU backends
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "output.h"
+#include "timer.h"
+#include "volume.h"
+
+/**
+ \brief Run 3D simulation using input parameters specified on the command line
+
+ The parameter file is read as for the 2D programs, plus the optional keys
+ \a nz and \a dz for the third dimension (\a dz defaults to \a dx) and \a zb,
+ nonzero to convolve in \a bx \f$\times\f$ \a by columns streamed along
+ \a z, see compute_convolution_3d_blocked(). The mask code is 73 for the
+ seven-point or 273 for the 27-point Laplacian, and the mask size must be 3.
+
+ Program will write PNG images and a final CSV raw data file of the midplane
+ \a z = \a nz/2, and a CSV runtime log tabulating the iteration counter
+ (\a iter), elapsed simulation time (\a sim_time), error relative to the
+ analytical solution over the whole volume (\a wrss), time spent performing
+ convolution (\a conv_time), time spent updating fields (\a step_time), time
+ spent writing to disk (\a IO_time), time spent generating analytical values
+ (\a soln_time), and total elapsed (\a run_time).
+*/
+int main(int argc, char* argv[])
+{
+	FILE * output;
+
+	/* declare default mesh size and resolution */
+	fp_t ***conc_old, ***conc_new, ***conc_lap, ***mask_lap;
+	int bx=32, by=32, nx=128, ny=128, nz=128, nm=3, code=73, blocked=0;
+	fp_t dx=0.5, dy=0.5, dz=-1., h;
+
+	/* declare default materials and numerical parameters */
+	fp_t D=0.00625, linStab=0.1, dt=1., elapsed=0., rss=0.;
+	int step=0, steps=1000, checks=250;
+	fp_t conv_time=0., step_time=0., file_time=0., soln_time=0.;
+
+	StartTimer();
+
+	param_parser(argc, argv, &bx, &by, &checks, &code, &D, &dx, &dy, &linStab, &nm, &nx, &ny, &steps);
+	param_optional_int(argc, argv, "nz", &nz);
+	param_optional_fp(argc, argv, "dz", &dz);
+	param_optional_int(argc, argv, "zb", &blocked);
+	if (dz <= 0.)
+		dz = dx;
+	if (nz < nm) {
+		printf("Error: nz=%i must be at least the mask size %i.\n", nz, nm);
+		exit(-1);
+	}
+
+	h = (dx > dy) ? dy : dx;
+	h = (h > dz) ? dz : h;
+	dt = (linStab * h * h) / (6.0 * D);
+
+	/* initialize memory */
+	make_arrays_3d(&conc_old, &conc_new, &conc_lap, &mask_lap, nx, ny, nz, nm);
+	set_mask_3d(dx, dy, dz, code, mask_lap, nm);
+
+	print_progress(0, steps);
+
+	timer_push("initial conditions");
+	apply_initial_conditions_3d(conc_old, nx, ny, nz, nm);
+	timer_pop();
+
+	/* prepare to log comparison to analytical solution */
+	output = fopen("runlog.csv", "w");
+	if (output == NULL) {
+		printf("Error: unable to %s for output. Check permissions.\n", "runlog.csv");
+		exit(-1);
+	}
+
+	fprintf(output, "iter,sim_time,wrss,conv_time,step_time,IO_time,soln_time,run_time\n");
+	fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f\n", step, elapsed, rss,
+	        conv_time, step_time, file_time, soln_time, GetTimer());
+
+	/* write initial condition data */
+	timer_push("write_png");
+	write_png(conc_old[nz/2], nx, ny, 0);
+	file_time += timer_pop();
+
+	/* do the work */
+	for (step = 1; step < steps+1; step++) {
+		print_progress(step, steps);
+
+		/* === Start Architecture-Specific Kernel === */
+		apply_boundary_conditions_3d(conc_old, nx, ny, nz, nm);
+
+		timer_push("convolution");
+		if (blocked)
+			compute_convolution_3d_blocked(conc_old, conc_lap, mask_lap, nx, ny, nz, nm, bx, by);
+		else
+			compute_convolution_3d(conc_old, conc_lap, mask_lap, nx, ny, nz, nm);
+		conv_time += timer_pop();
+
+		timer_push("update");
+		update_composition_3d(conc_old, conc_lap, conc_new, nx, ny, nz, nm, D, dt);
+		step_time += timer_pop();
+
+		swap_pointers_3d(&conc_old, &conc_new);
+		elapsed += dt;
+		/* === Finish Architecture-Specific Kernel === */
+
+		if (step % checks == 0) {
+			timer_push("write_png");
+			write_png(conc_old[nz/2], nx, ny, step);
+			file_time += timer_pop();
+
+			timer_push("check_solution");
+			check_solution_3d(conc_old, conc_lap, nx, ny, nz, dx, dy, dz, nm, elapsed, D, &rss);
+			soln_time += timer_pop();
+
+			fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f\n", step, elapsed, rss,
+			        conv_time, step_time, file_time, soln_time, GetTimer());
+			fflush(output);
+		}
+	}
+
+	write_csv(conc_old[nz/2], nx, ny, dx, dy, steps);
+
+	printf("3D %s %i-point Laplacian on %i x %i x %i: wrss %g at sim_time %g in %f s (convolution %f s)\n",
+	       blocked ? "blocked" : "naive", (code == 273) ? 27 : 7, nx, ny, nz, rss, elapsed, GetTimer(), conv_time);
+	timer_report(stdout);
+
+	/* clean up */
+	fclose(output);
+	free_arrays_3d(conc_old, conc_new, conc_lap, mask_lap);
+
+	return 0;
+}
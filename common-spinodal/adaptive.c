@@ -0,0 +1,45 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  adaptive.c
+ \brief Implementation of adaptive timestep control for spinodal decomposition
+*/
+
+#include <math.h>
+#include "adaptive.h"
+
+void init_controller(struct Controller* ctl, const fp_t tol, const fp_t dt, const fp_t energy)
+{
+	ctl->tol = tol;
+	ctl->dt = dt;
+	ctl->energy = energy;
+	ctl->accepted = 0;
+	ctl->rejected = 0;
+}
+
+int accept_step(struct Controller* ctl, const fp_t err, const fp_t energy)
+{
+	/* allow the energy to wander by roundoff once the microstructure is nearly static */
+	const int dissipative = (energy <= ctl->energy + 1.0e-12 * fabs(ctl->energy));
+	const int accurate = (err <= ctl->tol);
+	fp_t factor = (err > 0.) ? 0.9 * sqrt(ctl->tol / err) : 2.0;
+
+	if (factor > 2.0)
+		factor = 2.0;
+	else if (factor < 0.2)
+		factor = 0.2;
+
+	if (accurate && dissipative) {
+		ctl->energy = energy;
+		ctl->accepted++;
+		ctl->dt *= factor;
+		return 1;
+	}
+
+	ctl->rejected++;
+	ctl->dt *= (accurate) ? 0.5 : factor;
+	return 0;
+}
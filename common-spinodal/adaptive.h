@@ -0,0 +1,73 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  adaptive.h
+ \brief Declaration of adaptive timestep control for spinodal decomposition
+*/
+
+/** \cond SuppressGuard */
+#ifndef _ADAPTIVE_H_
+#define _ADAPTIVE_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief Timestep controller for the embedded Heun-Euler pair
+
+ Each trial step advances the composition with Heun's method (second order)
+ and estimates its local error as the largest difference from forward Euler
+ (first order) using the same two stages. A step is accepted only if that
+ error is within \a tol and the total free energy did not increase, since
+ Cahn-Hilliard dynamics dissipate energy. After either outcome, the next
+ trial \a dt is scaled by \f$ 0.9\sqrt{tol/err}\f$, limited to between a
+ fifth and twice its current value; a step rejected for raising the energy
+ halves \a dt instead.
+
+ Like forward Euler, Heun's method is only conditionally stable, so this
+ cannot step past the explicit limit of the biharmonic term; it instead
+ lets \a dt climb from a conservative \a co up to that limit and ride it,
+ backing off whenever error or energy shows the onset of instability.
+*/
+struct Controller {
+	/**
+	 Largest acceptable local error in composition
+	*/
+	fp_t tol;
+
+	/**
+	 Timestep for the next trial
+	*/
+	fp_t dt;
+
+	/**
+	 Free energy after the last accepted step
+	*/
+	fp_t energy;
+
+	/**
+	 Number of trial steps accepted and rejected
+	*/
+	int accepted, rejected;
+};
+
+/**
+ \brief Prepare \a ctl with tolerance \a tol, initial step \a dt, and initial free energy
+*/
+void init_controller(struct Controller* ctl, const fp_t tol, const fp_t dt, const fp_t energy);
+
+/**
+ \brief Judge a trial step and choose the next \a dt
+
+ \a err is the local error estimate and \a energy the free energy of the
+ trial solution. Returns 1 if the step is accepted, 0 if it must be retried
+ with the (reduced) \a ctl->dt.
+*/
+int accept_step(struct Controller* ctl, const fp_t err, const fp_t energy);
+
+/** \cond SuppressGuard */
+#endif /* _ADAPTIVE_H_ */
+/** \endcond */
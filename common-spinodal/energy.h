@@ -0,0 +1,135 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  energy.h
+ \brief Header-only polynomial free energy density shared by the spinodal backends
+*/
+
+/** \cond SuppressGuard */
+#ifndef _ENERGY_H_
+#define _ENERGY_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief Highest power of \a c in the free energy density
+
+ Define before including this header to admit higher-order polynomials.
+*/
+#ifndef ENERGY_DEGREE
+#define ENERGY_DEGREE 4
+#endif
+
+/** \cond SuppressGuard */
+#ifdef __CUDACC__
+#define ENERGY_INLINE __host__ __device__ static inline
+#else
+#define ENERGY_INLINE static inline
+#endif
+/** \endcond */
+
+/**
+ \brief Chemical free energy density \f$ f(c)\f$, as polynomial coefficients
+
+ Both \f$ f\f$ and \f$ f'\f$ are stored lowest power first and evaluated in
+ Horner form: branch-free multiply-adds that inline into the stencil loops
+ and vectorize with them. Any polynomial free energy up to #ENERGY_DEGREE is
+ supported by filling \a f and calling differentiate_energy();
+ double_well_energy() does so for the CHiMaD benchmark. The struct holds only
+ numbers, so CUDA kernels may take it by value.
+*/
+struct FreeEnergy {
+	/**
+	 Coefficients of \f$ f(c) = \sum_k f_k c^k\f$
+	*/
+	fp_t f[ENERGY_DEGREE + 1];
+
+	/**
+	 Coefficients of \f$ f'(c)\f$, from differentiate_energy()
+	*/
+	fp_t df[ENERGY_DEGREE];
+};
+
+/**
+ \brief Fill the coefficients of \f$ f'\f$ from those of \f$ f\f$
+*/
+ENERGY_INLINE void differentiate_energy(struct FreeEnergy* fe)
+{
+	for (int k = 0; k < ENERGY_DEGREE; k++)
+		fe->df[k] = (k + 1) * fe->f[k + 1];
+}
+
+/**
+ \brief Set \f$ f(c) = \rho(c - c_\alpha)^2(c_\beta - c)^2\f$, the symmetric double well
+
+ With \f$ s = c_\alpha + c_\beta\f$ and \f$ q = c_\alpha c_\beta\f$,
+ \f$ f = \rho(c^4 - 2sc^3 + (s^2 + 2q)c^2 - 2sqc + q^2)\f$.
+*/
+ENERGY_INLINE void double_well_energy(struct FreeEnergy* fe, const fp_t Ca, const fp_t Cb, const fp_t rho)
+{
+	const fp_t s = Ca + Cb;
+	const fp_t q = Ca * Cb;
+
+	for (int k = 0; k < ENERGY_DEGREE + 1; k++)
+		fe->f[k] = 0.;
+
+	fe->f[0] =  rho * q * q;
+	fe->f[1] = -2. * rho * s * q;
+	fe->f[2] =  rho * (s * s + 2. * q);
+	fe->f[3] = -2. * rho * s;
+	fe->f[4] =  rho;
+
+	differentiate_energy(fe);
+}
+
+/**
+ \brief Chemical free energy density \f$ f(c)\f$
+*/
+ENERGY_INLINE fp_t energy_density(const struct FreeEnergy* fe, const fp_t c)
+{
+	fp_t value = fe->f[ENERGY_DEGREE];
+	for (int k = ENERGY_DEGREE - 1; k >= 0; k--)
+		value = value * c + fe->f[k];
+	return value;
+}
+
+/**
+ \brief Chemical potential contribution \f$ f'(c)\f$
+*/
+ENERGY_INLINE fp_t energy_derivative(const struct FreeEnergy* fe, const fp_t c)
+{
+	fp_t value = fe->df[ENERGY_DEGREE - 1];
+	for (int k = ENERGY_DEGREE - 2; k >= 0; k--)
+		value = value * c + fe->df[k];
+	return value;
+}
+
+#ifndef __CUDACC__
+/**
+ \brief Evaluate \f$ f'\f$ over \a n contiguous values, in SIMD lanes
+*/
+static inline void energy_derivative_row(const struct FreeEnergy* fe, const fp_t* c, fp_t* out, const int n)
+{
+	#pragma omp simd
+	for (int i = 0; i < n; i++)
+		out[i] = energy_derivative(fe, c[i]);
+}
+
+/**
+ \brief Evaluate \f$ f\f$ over \a n contiguous values, in SIMD lanes
+*/
+static inline void energy_density_row(const struct FreeEnergy* fe, const fp_t* c, fp_t* out, const int n)
+{
+	#pragma omp simd
+	for (int i = 0; i < n; i++)
+		out[i] = energy_density(fe, c[i]);
+}
+#endif
+
+/** \cond SuppressGuard */
+#endif /* _ENERGY_H_ */
+/** \endcond */
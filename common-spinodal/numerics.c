@@ -66,101 +66,57 @@ void biharmonic_stencil(const fp_t dx, const fp_t dy, fp_t** mask_lap, const int
 {
 	assert(nm == 5);
 
-	mask_lap[0][2] =  1. / (dy * dy); /* upper-upper-middle */
+	/* five_point_Laplacian_stencil() convolved with itself */
+	mask_lap[0][2] =  1. / (dy*dy * dy*dy); /* upper-upper-middle */
 
-	mask_lap[1][1] =  2. / (dx * dy); /* upper-left */
-	mask_lap[1][2] = -8. / (dy * dy); /* upper-middle */
-	mask_lap[1][3] =  2. / (dx * dy); /* upper-right */
+	mask_lap[1][1] =  2. / (dx*dx * dy*dy); /* upper-left */
+	mask_lap[1][2] = -4. * (dx*dx + dy*dy) / (dx*dx * dy*dy * dy*dy); /* upper-middle */
+	mask_lap[1][3] =  2. / (dx*dx * dy*dy); /* upper-right */
 
-	mask_lap[2][0] =  1. / (dx * dx); /* middle-left-left */
-	mask_lap[2][1] = -8. / (dx * dx); /* middle-left */
-	mask_lap[2][2] = 10. * (dx*dx + dy*dy) / (dx*dx * dy*dy); /* middle */
-	mask_lap[2][3] = -8. / (dx * dx); /* middle-right */
-	mask_lap[2][4] =  1. / (dx * dx); /* middle-right-right */
+	mask_lap[2][0] =  1. / (dx*dx * dx*dx); /* middle-left-left */
+	mask_lap[2][1] = -4. * (dx*dx + dy*dy) / (dx*dx * dx*dx * dy*dy); /* middle-left */
+	mask_lap[2][2] =  6. / (dx*dx * dx*dx) + 8. / (dx*dx * dy*dy) + 6. / (dy*dy * dy*dy); /* middle */
+	mask_lap[2][3] = -4. * (dx*dx + dy*dy) / (dx*dx * dx*dx * dy*dy); /* middle-right */
+	mask_lap[2][4] =  1. / (dx*dx * dx*dx); /* middle-right-right */
 
-	mask_lap[3][1] =  2. / (dx * dy); /* lower-left */
-	mask_lap[3][2] = -8. / (dy * dy); /* lower-middle */
-	mask_lap[3][3] =  2. / (dx * dy); /* lower-right */
+	mask_lap[3][1] =  2. / (dx*dx * dy*dy); /* lower-left */
+	mask_lap[3][2] = -4. * (dx*dx + dy*dy) / (dx*dx * dy*dy * dy*dy); /* lower-middle */
+	mask_lap[3][3] =  2. / (dx*dx * dy*dy); /* lower-right */
 
-	mask_lap[4][2] =  1. / (dy * dy); /* lower-lower-middle */
+	mask_lap[4][2] =  1. / (dy*dy * dy*dy); /* lower-lower-middle */
 }
 
-fp_t grad_sq(fp_t** conc, const int x, const int y,
-			 const fp_t dx, const fp_t dy,
-			 const int nx, const int ny)
-{
-	assert(x > 0 && x < nx-1);
-	assert(y > 0 && y < ny-1);
-
-	int i=x, j=y;
-	fp_t gsq=0.;
-
-	/* gradient in x-direction */
-	i += 1;
-	const fp_t xhi = conc[j][i];
-	i -= 2;
-	const fp_t xlo = conc[j][i];
-	i += 1;
-
-	gsq += (xhi - xlo) * (xhi - xlo) / (4. * dx * dx);
-
-	/* gradient in y-direction */
-	j += 1;
-	const fp_t yhi = conc[j][i];
-	j -= 2;
-	const fp_t ylo = conc[j][i];
-	j += 1;
-
-	gsq += (yhi - ylo) * (yhi - ylo) / (4. * dy * dy);
-
-	return gsq;
-}
-
-fp_t chem_energy(const fp_t C)
-{
-	const fp_t Ca  = 0.3;
-	const fp_t Cb  = 0.7;
-	const fp_t rho = 5.0;
-
-	const fp_t A = C - Ca;
-	const fp_t B = Cb - C;
-
-	return rho * A*A * B*B;
-}
-
-void free_energy(fp_t** conc_new, fp_t** conc_lap,
+void free_energy(fp_t** conc_new,
 				 const fp_t dx, const fp_t dy,
 				 const int nx, const int ny, const int nm,
-				 const fp_t kappa, fp_t* energy)
+				 const struct FreeEnergy* fe, const fp_t kappa, fp_t* energy)
 {
 	const fp_t dV = dx * dy;
-	int i, j;
-	fp_t sum=0.;
+	const fp_t wx = 0.5 * kappa / (4. * dx * dx);
+	const fp_t wy = 0.5 * kappa / (4. * dy * dy);
+	fp_t sum = 0.;
 
-	#ifdef __OPENMP
-	#pragma omp parallel reduction(+:sum)
-	{
-		#pragma omp for collapse(2) private (i,j)
+	#ifdef _OPENMP
+	#pragma omp parallel for reduction(+:sum) schedule(static)
 	#endif
-		for (j = nm/2; j < ny-nm/2; j++) {
-			for (i = nm/2; i < nx-nm/2; i++) {
-				const fp_t f = chem_energy(conc_new[j][i]);
-				const fp_t g = grad_sq(conc_new, i, j, dx, dy, nx, ny);
-				conc_lap[j][i] = dV * (f + 0.5 * kappa * g);
-			}
-		}
-
-		#ifdef __OPENMP
-		#pragma omp for collapse(2) private(i,j)
+	for (int j = nm/2; j < ny-nm/2; j++) {
+		/* three adjacent rows supply both central differences */
+		const fp_t* lo = conc_new[j-1];
+		const fp_t* c  = conc_new[j];
+		const fp_t* hi = conc_new[j+1];
+		fp_t row = 0.;
+
+		#ifdef _OPENMP
+		#pragma omp simd reduction(+:row)
 		#endif
-		for (j = nm/2; j < ny-nm/2; j++) {
-			for (i = nm/2; i < nx-nm/2; i++) {
-				sum += conc_lap[j][i];
-			}
+		for (int i = nm/2; i < nx-nm/2; i++) {
+			const fp_t gx = c[i+1] - c[i-1];
+			const fp_t gy = hi[i] - lo[i];
+			row += energy_density(fe, c[i]) + wx * gx * gx + wy * gy * gy;
 		}
-	#ifdef __OPENMP
+
+		sum += row;
 	}
-	#endif
 
-	*energy = sum;
+	*energy = dV * sum;
 }
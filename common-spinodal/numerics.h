@@ -14,6 +14,7 @@
 /** \endcond */
 
 #include "type.h"
+#include "energy.h"
 
 /**
  \brief Maximum width of the convolution mask (Laplacian stencil) array
@@ -68,7 +69,8 @@ void biharmonic_stencil(const fp_t dx, const fp_t dy, fp_t** mask_lap, const int
    \brief Compute interior Laplacian from old composition data
 */
 void compute_laplacian(fp_t** const conc_old, fp_t** conc_lap, fp_t** const mask_lap,
-                       const fp_t kappa, const int nx, const int ny, const int nm);
+                       const struct FreeEnergy* fe, const fp_t kappa,
+                       const int nx, const int ny, const int nm);
 
 /**
  \brief Compute exterior Laplacian (divergence of gradient of Laplacian)
@@ -84,24 +86,69 @@ void update_composition(fp_t** conc_old, fp_t** conc_div, fp_t** conc_new,
                         const fp_t D, const fp_t dt);
 
 /**
-   \brief Compute gradient-squared, truncation error \f$\mathcal{O}(\Delta x^2)\f$
+ \brief Evaluate \f$ f'(c)\f$ everywhere, ghost cells included, into \a conc_chem
 */
-fp_t grad_sq(fp_t** conc, const int x, const int y,
-             const fp_t dx, const fp_t dy,
-             const int nx, const int ny);
+void compute_chemical(fp_t** conc, fp_t** conc_chem, const struct FreeEnergy* fe,
+                      const int nx, const int ny);
 
 /**
-   \brief Compute chemical free energy density
+ \brief Compute \f$\nabla^2 f'(c) - \kappa\nabla^4 c\f$ into \a conc_div, with the operator split
+
+ Rather than convolving twice with \a mask_lap, as compute_laplacian() and
+ compute_divergence() do, applies the five-point Laplacian in \a mask_chem to
+ \a conc_chem, from compute_chemical(), and the 13-point biharmonic in
+ \a mask_bih (code 135, \a nm = 5) to \a conc, in a single sweep. The nonzero
+ weights are read once into scalars and each row is a unit-stride SIMD loop.
+ Away from the walls the two paths differ only by rounding; at the walls, the
+ reflected ghost layers set by apply_boundary_conditions() make them agree,
+ too.
 */
-fp_t chem_energy(const fp_t C);
+void compute_split_rate(fp_t** conc, fp_t** conc_chem, fp_t** conc_div,
+                        fp_t** mask_chem, fp_t** mask_bih, const fp_t kappa,
+                        const int nx, const int ny, const int nm);
+
+/**
+ \brief Take a forward Euler step in a single sweep, as compute_laplacian(),
+ compute_divergence(), and update_composition() in turn
+
+ The chemical potential is computed row by row into a ring of \a nm rows,
+ with its no-flux ghost values filled in place, and each row of the update is
+ completed \a nm/2 rows behind, once the ring holds every row its stencil
+ needs. \a conc_old must have its boundary conditions applied. The chemical
+ potential and divergence fields are never stored, so each step reads
+ \a conc_old and writes \a conc_new once, rather than sweeping four
+ fields; the arithmetic, and hence the result, is unchanged.
+*/
+void update_composition_fused(fp_t** conc_old, fp_t** conc_new, fp_t** mask_lap,
+                              const struct FreeEnergy* fe, const fp_t kappa,
+                              const int nx, const int ny, const int nm,
+                              const fp_t M, const fp_t dt);
+
+/**
+ \brief Complete a Heun step and return its local error estimate
+
+ Given the rates \a rate_old at \a conc_old and \a rate_mid at the Euler
+ predictor, sets \f$ c_{new} = c_{old} + \frac{\Delta t}{2} M (r_{old} + r_{mid})\f$
+ and returns \f$ \max\left|\frac{\Delta t}{2} M (r_{mid} - r_{old})\right|\f$,
+ the difference between the Heun and forward Euler solutions.
+*/
+fp_t update_heun(fp_t** conc_old, fp_t** rate_old, fp_t** rate_mid, fp_t** conc_new,
+                 const int nx, const int ny, const int nm,
+                 const fp_t M, const fp_t dt);
 
 /**
- \brief Compute total free energy
+ \brief Compute total free energy, with chemical density energy_density()
+
+ Streams the field a row at a time: the centered-difference gradient-squared,
+ with truncation error \f$\mathcal{O}(\Delta x^2)\f$, comes from unit-stride
+ loads of the row and its two neighbors, each row is summed in SIMD lanes,
+ and rows are shared among OpenMP threads, each keeping its own partial sum.
+ \a conc_new must have its boundary conditions applied.
 */
-void free_energy(fp_t** conc_new, fp_t** conc_lap,
+void free_energy(fp_t** conc_new,
                  const fp_t dx, const fp_t dy,
                  const int nx, const int ny, const int nm,
-                 const fp_t kappa, fp_t* energy);
+                 const struct FreeEnergy* fe, const fp_t kappa, fp_t* energy);
 
 /** \cond SuppressGuard */
 #endif /* _NUMERICS_H_ */
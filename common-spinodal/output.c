@@ -15,6 +15,27 @@
 #include <png.h>
 #include "output.h"
 
+/**
+ \brief Keys read by param_optional_int() and param_optional_fp(), not param_parser()
+
+ \a tl: error tolerance for adaptive timestepping, see struct Controller; 0 keeps \a dt fixed \n
+ \a fu: nonzero to take fixed steps in one fused sweep, see update_composition_fused() \n
+ \a ca, \a cb: compositions of the two minima of the double well, see double_well_energy() \n
+ \a rh: height parameter \f$\rho\f$ of the double well
+*/
+static const char* optional_keys[] = {"tl", "fu", "ca", "cb", "rh", NULL};
+
+/**
+ \brief Check whether \a key is one of the #optional_keys
+*/
+static int is_optional_key(const char* key)
+{
+	for (int k = 0; optional_keys[k] != NULL; k++)
+		if (strcmp(key, optional_keys[k]) == 0)
+			return 1;
+	return 0;
+}
+
 void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* code,
 				  fp_t* M, fp_t* kappa, fp_t* linStab, int* nm,
 				  int* nx, int* ny, int* steps)
@@ -84,7 +105,7 @@ void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* co
 					pch = strtok(NULL, " ");
 					*code = atoi(pch);
 					isc = 1;
-				} else {
+				} else if (! is_optional_key(pch)) {
 					printf("Warning: unknown key %s. Ignoring value.\n", pch);
 				}
 			}
@@ -116,6 +137,56 @@ void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* co
 	fclose(input);
 }
 
+/**
+ \brief Copy the value following \a key in the parameter file into \a value
+
+ \return 1 if \a key was found, 0 otherwise
+*/
+static int find_optional(int argc, char* argv[], const char* key, char* value)
+{
+	FILE * input;
+	char buffer[256];
+	char* pch;
+	int found = 0;
+
+	if (argc != 2)
+		return 0;
+
+	input = fopen(argv[1], "r");
+	if (input == NULL)
+		return 0;
+
+	while (!found && fgets(buffer, 256, input) != NULL) {
+		pch = strtok(buffer, " ");
+		if (pch != NULL && strcmp(pch, key) == 0) {
+			pch = strtok(NULL, " ");
+			if (pch != NULL) {
+				strncpy(value, pch, 255);
+				found = 1;
+			}
+		}
+	}
+
+	fclose(input);
+	return found;
+}
+
+void param_optional_int(int argc, char* argv[], const char* key, int* value)
+{
+	char buffer[256] = {'\0'};
+
+	if (find_optional(argc, argv, key, buffer))
+		*value = atoi(buffer);
+}
+
+void param_optional_fp(int argc, char* argv[], const char* key, fp_t* value)
+{
+	char buffer[256] = {'\0'};
+
+	if (find_optional(argc, argv, key, buffer))
+		*value = atof(buffer);
+}
+
 void print_progress(const int step, const int steps)
 {
 	static unsigned long tstart;
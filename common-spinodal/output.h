@@ -21,6 +21,20 @@
 void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* code,
                   fp_t* M, fp_t* kappa, fp_t* linStab, int* nm, int* nx, int* ny, int* steps);
 
+/**
+ \brief Read an optional integer parameter from the file specified on the command line
+
+ Optional keys tune individual backends and need not be present; if \a key
+ is absent, \a value keeps its default. param_parser() skips these keys
+ without complaint.
+*/
+void param_optional_int(int argc, char* argv[], const char* key, int* value);
+
+/**
+ \brief Read an optional floating-point parameter, as param_optional_int()
+*/
+void param_optional_fp(int argc, char* argv[], const char* key, fp_t* value);
+
 /**
  \brief Prints timestamps and a 20-point progress bar to stdout
 
@@ -14,16 +14,74 @@
 #define _TIMER_H_
 /** \endcond */
 
+#include <stdio.h>
+
+/**
+ \brief Largest number of distinct (name, parent) scopes
+*/
+#define TIMER_MAX_SCOPES 64
+
+/**
+ \brief Deepest nesting of timer_push() calls on one thread
+*/
+#define TIMER_MAX_DEPTH 16
+
+/**
+ \brief Largest number of threads with their own scope accumulators
+*/
+#define TIMER_MAX_THREADS 256
+
 /**
  \brief Set CPU frequency and begin timing
+
+ Reads \c CLOCK_MONOTONIC_RAW by default, which is immune to NTP slewing
+ and has nanosecond resolution. Compiling with \c -DTIMER_TSC on x86 reads
+ the time-stamp counter instead, calibrated here against the monotonic
+ clock over a few milliseconds; this requires an invariant TSC. Call once,
+ before any other timer function and before threads are spawned.
 */
 void StartTimer();
 
 /**
- \brief Return elapsed time in seconds
+ \brief Return elapsed time in seconds since StartTimer(); safe from any thread
 */
 double GetTimer();
 
+/**
+ \brief Raw value of the underlying clock, in ticks
+*/
+unsigned long long TimerTicks();
+
+/**
+ \brief Length of one tick, in seconds
+*/
+double TimerResolution();
+
+/**
+ \brief Begin timing scope \a name on the calling thread
+
+ Scopes nest: a scope pushed while another is open becomes its child, so the
+ same \a name under different parents is accumulated separately. \a name
+ must be a string literal or otherwise outlive the program's timers. Each
+ thread accumulates into its own table, so no locks are taken except the
+ first time a thread, or a (name, parent) pair, is seen.
+*/
+void timer_push(const char* name);
+
+/**
+ \brief End the innermost scope on the calling thread
+
+ \return seconds elapsed since the matching timer_push(), which callers add
+ to the appropriate field of struct Stopwatch
+*/
+double timer_pop();
+
+/**
+ \brief Print calls and seconds of every scope, summed over threads, with
+ the largest per-thread total alongside to expose load imbalance
+*/
+void timer_report(FILE* output);
+
 /** \cond SuppressGuard */
 #endif /* _TIMER_H_ */
 /** \endcond */
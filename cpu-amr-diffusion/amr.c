@@ -0,0 +1,412 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  amr.c
+ \brief Implementation of block-structured adaptive mesh refinement for diffusion benchmarks
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "amr.h"
+#include "boundaries.h"
+#include "mesh.h"
+#include "numerics.h"
+#include "timer.h"
+
+fp_t** amr_make_field(const int nx, const int ny)
+{
+	fp_t** field = (fp_t**)calloc(ny, sizeof(fp_t*));
+	field[0] = (fp_t*)calloc(nx * ny, sizeof(fp_t));
+	for (int j = 1; j < ny; j++)
+		field[j] = &(field[0][nx * j]);
+	return field;
+}
+
+void amr_free_field(fp_t** field)
+{
+	free(field[0]);
+	free(field);
+}
+
+/**
+ \brief Value of block \a b at global fine cell (\a gi, \a gj) in \a field
+*/
+#define BLOCK_VALUE(amr, b, field, gi, gj) \
+	((b)->field[(gj) - (b)->bj * (amr)->bh + (amr)->hw][(gi) - (b)->bi * (amr)->bw + (amr)->hw])
+
+static fp_t minmod(const fp_t a, const fp_t b)
+{
+	if (a * b <= 0.)
+		return 0.;
+	return (fabs(a) < fabs(b)) ? a : b;
+}
+
+/**
+ \brief Conservative, slope-limited value of fine cell (\a gi, \a gj) from its coarse parent
+*/
+static fp_t prolong(const struct AMR* amr, fp_t** coarse, const int gi, const int gj)
+{
+	const int I = gi / 2;
+	const int J = gj / 2;
+	const fp_t c = coarse[J][I];
+	fp_t sx = 0., sy = 0.;
+
+	if (I > 0 && I < amr->ncx - 1)
+		sx = minmod(coarse[J][I+1] - c, c - coarse[J][I-1]);
+	if (J > 0 && J < amr->ncy - 1)
+		sy = minmod(coarse[J+1][I] - c, c - coarse[J-1][I]);
+
+	/* children sit a quarter of the parent's width from its center */
+	return c + 0.25 * sx * (2 * (gi % 2) - 1) + 0.25 * sy * (2 * (gj % 2) - 1);
+}
+
+void make_amr(struct AMR* amr, const int nx, const int ny, const int bw, const int bh,
+              const int nm, const fp_t dx, const fp_t dy, const int code, const fp_t threshold)
+{
+	if (bw % 2 || bh % 2 || bw < nm || bh < nm) {
+		printf("Error: AMR blocks (%i x %i) must be even and at least %i wide.\n", bw, bh, nm);
+		exit(-1);
+	}
+	if (nx % bw || ny % bh) {
+		printf("Error: mesh (%i x %i) is not a whole number of %i x %i blocks.\n", nx, ny, bw, bh);
+		exit(-1);
+	}
+
+	amr->nx = nx;
+	amr->ny = ny;
+	amr->nm = nm;
+	amr->hw = nm/2;
+	amr->bw = bw;
+	amr->bh = bh;
+	amr->nbx = nx / bw;
+	amr->nby = ny / bh;
+	amr->ncx = nx / 2;
+	amr->ncy = ny / 2;
+	amr->threshold = threshold;
+	amr->sweep_time = 0.;
+	amr->sync_time = 0.;
+
+	amr->coarse_old = amr_make_field(amr->ncx, amr->ncy);
+	amr->coarse_new = amr_make_field(amr->ncx, amr->ncy);
+	amr->coarse_lap = amr_make_field(amr->ncx, amr->ncy);
+	amr->mask_coarse = amr_make_field(nm, nm);
+	amr->mask_fine = amr_make_field(nm, nm);
+	set_mask(2. * dx, 2. * dy, code, amr->mask_coarse, nm);
+	set_mask(dx, dy, code, amr->mask_fine, nm);
+
+	amr->map = (struct Block**)calloc(amr->nbx * amr->nby, sizeof(struct Block*));
+	amr->active = (struct Block**)calloc(amr->nbx * amr->nby, sizeof(struct Block*));
+	amr->nactive = 0;
+}
+
+static struct Block* make_block(const struct AMR* amr, const int bi, const int bj)
+{
+	struct Block* b = (struct Block*)malloc(sizeof(struct Block));
+	const int pw = amr->bw + 2 * amr->hw;
+	const int ph = amr->bh + 2 * amr->hw;
+
+	b->bi = bi;
+	b->bj = bj;
+	b->conc_old = amr_make_field(pw, ph);
+	b->conc_new = amr_make_field(pw, ph);
+	b->conc_lap = amr_make_field(pw, ph);
+
+	return b;
+}
+
+static void free_block(struct Block* b)
+{
+	amr_free_field(b->conc_old);
+	amr_free_field(b->conc_new);
+	amr_free_field(b->conc_lap);
+	free(b);
+}
+
+void free_amr(struct AMR* amr)
+{
+	for (int k = 0; k < amr->nbx * amr->nby; k++)
+		if (amr->map[k] != NULL)
+			free_block(amr->map[k]);
+	free(amr->map);
+	free(amr->active);
+
+	amr_free_field(amr->coarse_old);
+	amr_free_field(amr->coarse_new);
+	amr_free_field(amr->coarse_lap);
+	amr_free_field(amr->mask_coarse);
+	amr_free_field(amr->mask_fine);
+}
+
+/**
+ \brief Does block (\a bi, \a bj) contain part of a fixed-value wall?
+*/
+static int touches_wall(const struct AMR* amr, const int bi, const int bj)
+{
+	const int i0 = bi * amr->bw;
+	const int j0 = bj * amr->bh;
+	const int nm = amr->nm;
+
+	return (i0 < 1 + nm/2 && j0 < amr->ny/2)
+	    || (i0 + amr->bw > amr->nx - 1 - nm/2 && j0 + amr->bh > amr->ny/2);
+}
+
+/**
+ \brief Largest change in composition across one coarse cell within the footprint of block (\a bi, \a bj)
+*/
+static fp_t block_gradient(const struct AMR* amr, const int bi, const int bj)
+{
+	fp_t** c = amr->coarse_old;
+	const int I0 = bi * amr->bw / 2;
+	const int J0 = bj * amr->bh / 2;
+	fp_t grad = 0.;
+
+	for (int J = J0; J < J0 + amr->bh/2; J++) {
+		for (int I = I0; I < I0 + amr->bw/2; I++) {
+			const int il = (I > 0) ? I-1 : I;
+			const int ih = (I < amr->ncx - 1) ? I+1 : I;
+			const int jl = (J > 0) ? J-1 : J;
+			const int jh = (J < amr->ncy - 1) ? J+1 : J;
+			const fp_t gx = fabs(c[J][ih] - c[J][il]) / (ih - il);
+			const fp_t gy = fabs(c[jh][I] - c[jl][I]) / (jh - jl);
+			if (gx > grad)
+				grad = gx;
+			if (gy > grad)
+				grad = gy;
+		}
+	}
+
+	return grad;
+}
+
+void amr_regrid(struct AMR* amr)
+{
+	const int nbx = amr->nbx;
+	const int nby = amr->nby;
+	char* flag = (char*)calloc(nbx * nby, sizeof(char));
+	char* keep = (char*)calloc(nbx * nby, sizeof(char));
+
+	for (int bj = 0; bj < nby; bj++)
+		for (int bi = 0; bi < nbx; bi++)
+			flag[bj * nbx + bi] = touches_wall(amr, bi, bj)
+			                   || block_gradient(amr, bi, bj) > amr->threshold;
+
+	/* buffer by one block, so the front stays on the fine level until the next regrid */
+	for (int bj = 0; bj < nby; bj++)
+		for (int bi = 0; bi < nbx; bi++)
+			for (int dj = -1; dj < 2; dj++)
+				for (int di = -1; di < 2; di++)
+					if (bi + di >= 0 && bi + di < nbx && bj + dj >= 0 && bj + dj < nby
+					    && flag[(bj + dj) * nbx + bi + di])
+						keep[bj * nbx + bi] = 1;
+
+	amr->nactive = 0;
+	for (int bj = 0; bj < nby; bj++) {
+		for (int bi = 0; bi < nbx; bi++) {
+			const int k = bj * nbx + bi;
+
+			if (keep[k] && amr->map[k] == NULL) {
+				struct Block* b = make_block(amr, bi, bj);
+				for (int gj = bj * amr->bh; gj < (bj + 1) * amr->bh; gj++)
+					for (int gi = bi * amr->bw; gi < (bi + 1) * amr->bw; gi++)
+						BLOCK_VALUE(amr, b, conc_old, gi, gj) = prolong(amr, amr->coarse_old, gi, gj);
+				amr->map[k] = b;
+			} else if (!keep[k] && amr->map[k] != NULL) {
+				/* coarse cells beneath already hold the restricted solution */
+				free_block(amr->map[k]);
+				amr->map[k] = NULL;
+			}
+
+			if (amr->map[k] != NULL)
+				amr->active[amr->nactive++] = amr->map[k];
+		}
+	}
+
+	free(flag);
+	free(keep);
+}
+
+/**
+ \brief Initial conditions on block \a b, in global fine indices, as apply_initial_conditions()
+*/
+static void block_initial_conditions(const struct AMR* amr, struct Block* b)
+{
+	const int nm = amr->nm;
+
+	for (int gj = b->bj * amr->bh; gj < (b->bj + 1) * amr->bh; gj++) {
+		for (int gi = b->bi * amr->bw; gi < (b->bi + 1) * amr->bw; gi++) {
+			const int wall = (gj < amr->ny/2 && gi < 1+nm/2)
+			              || (gj >= amr->ny/2 && gi >= amr->nx-1-nm/2);
+			BLOCK_VALUE(amr, b, conc_old, gi, gj) = wall ? 1.0 : 0.0;
+		}
+	}
+}
+
+void amr_initial_conditions(struct AMR* amr)
+{
+	apply_initial_conditions(amr->coarse_old, amr->ncx, amr->ncy, amr->nm);
+	amr_regrid(amr);
+
+	for (int k = 0; k < amr->nactive; k++)
+		block_initial_conditions(amr, amr->active[k]);
+}
+
+/**
+ \brief Boundary conditions on the cells of block \a b, as apply_boundary_conditions() on the fine mesh
+
+ Every source and destination cell lies within the block, since blocks are
+ at least \a nm wide and tile the mesh exactly.
+*/
+static void block_boundary_conditions(const struct AMR* amr, struct Block* b)
+{
+	const int nx = amr->nx;
+	const int ny = amr->ny;
+	const int nm = amr->nm;
+	const int i0 = b->bi * amr->bw;
+	const int j0 = b->bj * amr->bh;
+	const int i1 = i0 + amr->bw;
+	const int j1 = j0 + amr->bh;
+
+	/* apply fixed boundary values: sequence does not matter */
+
+	for (int gj = j0; gj < j1 && gj < ny/2; gj++)
+		for (int gi = i0; gi < i1 && gi < 1+nm/2; gi++)
+			BLOCK_VALUE(amr, b, conc_old, gi, gj) = 1.0; /* left value */
+
+	for (int gj = (j0 > ny/2) ? j0 : ny/2; gj < j1; gj++)
+		for (int gi = (i0 > nx-1-nm/2) ? i0 : nx-1-nm/2; gi < i1; gi++)
+			BLOCK_VALUE(amr, b, conc_old, gi, gj) = 1.0; /* right value */
+
+	/* apply no-flux boundary conditions: inside to out, sequence matters */
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		for (int gj = j0; gj < j1; gj++) {
+			if (ilo-1 >= i0 && ilo-1 < i1)
+				BLOCK_VALUE(amr, b, conc_old, ilo-1, gj) = BLOCK_VALUE(amr, b, conc_old, ilo, gj); /* left condition */
+			if (ihi+1 >= i0 && ihi+1 < i1)
+				BLOCK_VALUE(amr, b, conc_old, ihi+1, gj) = BLOCK_VALUE(amr, b, conc_old, ihi, gj); /* right condition */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		for (int gi = i0; gi < i1; gi++) {
+			if (jlo-1 >= j0 && jlo-1 < j1)
+				BLOCK_VALUE(amr, b, conc_old, gi, jlo-1) = BLOCK_VALUE(amr, b, conc_old, gi, jlo); /* bottom condition */
+			if (jhi+1 >= j0 && jhi+1 < j1)
+				BLOCK_VALUE(amr, b, conc_old, gi, jhi+1) = BLOCK_VALUE(amr, b, conc_old, gi, jhi); /* top condition */
+		}
+	}
+}
+
+/**
+ \brief Fill the halo of block \a b from refined neighbors, or by prolongation where there are none
+
+ Halo cells beyond the mesh are never read by the stencil, and are skipped.
+*/
+static void fill_halo(const struct AMR* amr, struct Block* b)
+{
+	const int hw = amr->hw;
+
+	for (int y = -hw; y < amr->bh + hw; y++) {
+		for (int x = -hw; x < amr->bw + hw; x++) {
+			const int gi = b->bi * amr->bw + x;
+			const int gj = b->bj * amr->bh + y;
+			const struct Block* n;
+
+			if (x >= 0 && x < amr->bw && y >= 0 && y < amr->bh)
+				continue;
+			if (gi < 0 || gi >= amr->nx || gj < 0 || gj >= amr->ny)
+				continue;
+
+			n = amr->map[(gj / amr->bh) * amr->nbx + gi / amr->bw];
+			b->conc_old[y + hw][x + hw] = (n != NULL) ? BLOCK_VALUE(amr, n, conc_old, gi, gj)
+			                                          : prolong(amr, amr->coarse_old, gi, gj);
+		}
+	}
+}
+
+/**
+ \brief Replace coarse cells beneath block \a b with the mean of their children
+*/
+static void restrict_block(struct AMR* amr, const struct Block* b)
+{
+	const int I0 = b->bi * amr->bw / 2;
+	const int J0 = b->bj * amr->bh / 2;
+
+	for (int J = J0; J < J0 + amr->bh/2; J++) {
+		for (int I = I0; I < I0 + amr->bw/2; I++) {
+			amr->coarse_new[J][I] = 0.25 * (BLOCK_VALUE(amr, b, conc_new, 2*I,   2*J)
+			                              + BLOCK_VALUE(amr, b, conc_new, 2*I+1, 2*J)
+			                              + BLOCK_VALUE(amr, b, conc_new, 2*I,   2*J+1)
+			                              + BLOCK_VALUE(amr, b, conc_new, 2*I+1, 2*J+1));
+		}
+	}
+}
+
+void amr_step(struct AMR* amr, const fp_t D, const fp_t dt)
+{
+	const int pw = amr->bw + 2 * amr->hw;
+	const int ph = amr->bh + 2 * amr->hw;
+	const int nm = amr->nm;
+
+	/* both levels must be current before any halo reads them */
+	timer_push("boundaries");
+	apply_boundary_conditions(amr->coarse_old, amr->ncx, amr->ncy, nm);
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < amr->nactive; k++)
+		block_boundary_conditions(amr, amr->active[k]);
+	amr->sync_time += timer_pop();
+
+	timer_push("halo");
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < amr->nactive; k++)
+		fill_halo(amr, amr->active[k]);
+	amr->sync_time += timer_pop();
+
+	timer_push("coarse");
+	compute_convolution(amr->coarse_old, amr->coarse_lap, amr->mask_coarse, amr->ncx, amr->ncy, nm);
+	update_composition(amr->coarse_old, amr->coarse_lap, amr->coarse_new, amr->ncx, amr->ncy, nm, D, dt);
+	amr->sweep_time += timer_pop();
+
+	/* blocks write disjoint coarse footprints, so restriction needs no synchronization */
+	timer_push("fine");
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < amr->nactive; k++) {
+		struct Block* b = amr->active[k];
+		compute_convolution(b->conc_old, b->conc_lap, amr->mask_fine, pw, ph, nm);
+		update_composition(b->conc_old, b->conc_lap, b->conc_new, pw, ph, nm, D, dt);
+		restrict_block(amr, b);
+	}
+	amr->sweep_time += timer_pop();
+
+	swap_pointers(&amr->coarse_old, &amr->coarse_new);
+	for (int k = 0; k < amr->nactive; k++)
+		swap_pointers(&amr->active[k]->conc_old, &amr->active[k]->conc_new);
+}
+
+void amr_rasterize(const struct AMR* amr, fp_t** conc)
+{
+	#pragma omp parallel for collapse(2)
+	for (int bj = 0; bj < amr->nby; bj++) {
+		for (int bi = 0; bi < amr->nbx; bi++) {
+			const struct Block* b = amr->map[bj * amr->nbx + bi];
+			for (int gj = bj * amr->bh; gj < (bj + 1) * amr->bh; gj++)
+				for (int gi = bi * amr->bw; gi < (bi + 1) * amr->bw; gi++)
+					conc[gj][gi] = (b != NULL) ? BLOCK_VALUE(amr, b, conc_old, gi, gj)
+					                           : prolong(amr, amr->coarse_old, gi, gj);
+		}
+	}
+}
+
+long amr_cells(const struct AMR* amr)
+{
+	const long block = (long)(amr->bw + 2 * amr->hw) * (amr->bh + 2 * amr->hw);
+	return 3L * amr->ncx * amr->ncy + 3L * block * amr->nactive;
+}
@@ -0,0 +1,179 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  amr.h
+ \brief Declaration of block-structured adaptive mesh refinement for diffusion benchmarks
+*/
+
+/** \cond SuppressGuard */
+#ifndef _AMR_H_
+#define _AMR_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief One refined block: \a bw \f$\times\f$ \a bh fine cells with a halo
+
+ Fields are \f$(bw + 2h) \times (bh + 2h)\f$ row-major \c fp_t** arrays,
+ \a h = \a nm/2, so that compute_convolution() and update_composition() sweep
+ exactly the block interior when handed the padded size. Local cell
+ (\a x, \a y) is \c conc[y + h][x + h], global fine cell
+ (\a bi \f$\cdot\f$ \a bw + \a x, \a bj \f$\cdot\f$ \a bh + \a y).
+*/
+struct Block {
+	/**
+	 Block indices in the block grid
+	*/
+	int bi, bj;
+
+	/**
+	 Composition, its Laplacian, and the updated composition
+	*/
+	fp_t **conc_old, **conc_new, **conc_lap;
+};
+
+/**
+ \brief Two-level composite grid: coarse base with fine blocks where needed
+
+ The fine level has the resolution (\a dx, \a dy) and extent (\a nx
+ \f$\times\f$ \a ny) of the uniform backends, divided into a grid of
+ \a bw \f$\times\f$ \a bh blocks, of which only the refined ones are
+ allocated. The coarse level covers the whole domain at twice the spacing,
+ \a nx/2 \f$\times\f$ \a ny/2 cells, each the parent of a \f$ 2\times 2\f$
+ group of fine cells. Both levels advance with the same \a dt, limited by the
+ fine spacing.
+
+ Coarse-fine transfers conserve the cell average: restriction replaces each
+ coarse cell under a block with the mean of its four children, and
+ prolongation (for block halos, new blocks, and output) fills children with
+ the parent value plus minmod-limited slopes, which sum to zero over the four.
+*/
+struct AMR {
+	/**
+	 Fine mesh size, mask size, and halo width \a nm/2
+	*/
+	int nx, ny, nm, hw;
+
+	/**
+	 Block size in fine cells, and number of blocks along \a x and \a y
+	*/
+	int bw, bh, nbx, nby;
+
+	/**
+	 Coarse mesh size
+	*/
+	int ncx, ncy;
+
+	/**
+	 Coarse composition, Laplacian, and update
+	*/
+	fp_t **coarse_old, **coarse_new, **coarse_lap;
+
+	/**
+	 Laplacian masks for the coarse (\f$ 2\Delta x\f$) and fine (\f$\Delta x\f$) levels
+	*/
+	fp_t **mask_coarse, **mask_fine;
+
+	/**
+	 Refined blocks by block index, \c NULL where the coarse level suffices
+	*/
+	struct Block** map;
+
+	/**
+	 Refined blocks, packed for parallel sweeps
+	*/
+	struct Block** active;
+
+	/**
+	 Number of refined blocks
+	*/
+	int nactive;
+
+	/**
+	 Refine blocks where the composition changes by more than this across one coarse cell
+	*/
+	fp_t threshold;
+
+	/**
+	 Time spent in stencil sweeps over both levels, and in boundary conditions
+	 and halo exchange, over all calls to amr_step()
+	*/
+	fp_t sweep_time, sync_time;
+};
+
+/**
+ \brief Allocate an \a nx \f$\times\f$ \a ny field, as make_arrays()
+*/
+fp_t** amr_make_field(const int nx, const int ny);
+
+/**
+ \brief Free a field from amr_make_field()
+*/
+void amr_free_field(fp_t** field);
+
+/**
+ \brief Allocate the coarse level and set both masks; no blocks are refined yet
+
+ \a nx and \a ny must be multiples of the even block size \a bw \f$\times\f$
+ \a bh, which must be at least \a nm.
+*/
+void make_amr(struct AMR* amr, const int nx, const int ny, const int bw, const int bh,
+              const int nm, const fp_t dx, const fp_t dy, const int code, const fp_t threshold);
+
+/**
+ \brief Free both levels
+*/
+void free_amr(struct AMR* amr);
+
+/**
+ \brief Initial conditions on both levels, as apply_initial_conditions()
+
+ The coarse level is initialized first, then regridded, so that refined
+ blocks start from the exact fine initial condition rather than prolongated
+ values.
+*/
+void amr_initial_conditions(struct AMR* amr);
+
+/**
+ \brief Choose blocks to refine from the current coarse solution
+
+ A block is refined if the composition anywhere in its footprint changes by
+ more than \a threshold across a coarse cell, if it neighbors such a block
+ (so the front cannot outrun the fine level between regrids), or if it
+ touches a fixed-value wall. Newly refined blocks are filled by prolongation
+ from the coarse level; blocks no longer needed are freed, their data having
+ already been restricted.
+*/
+void amr_regrid(struct AMR* amr);
+
+/**
+ \brief Advance both levels by one step of \a dt
+
+ Boundary conditions are applied to both levels, block halos are filled from
+ refined neighbors or by prolongation from the coarse level, both levels are
+ convolved and updated with the serial kernels (refined blocks in parallel),
+ the fine solution is restricted onto the coarse, and old and new swap.
+*/
+void amr_step(struct AMR* amr, const fp_t D, const fp_t dt);
+
+/**
+ \brief Rasterize the composite solution onto a uniform \a nx \f$\times\f$ \a ny field
+
+ Refined blocks are copied, the rest prolongated from the coarse level, so
+ that write_png(), write_csv(), and check_solution() see the finest data
+ available everywhere.
+*/
+void amr_rasterize(const struct AMR* amr, fp_t** conc);
+
+/**
+ \brief Values stored by both levels, for comparison with \a nx \f$\times\f$ \a ny
+*/
+long amr_cells(const struct AMR* amr);
+
+/** \cond SuppressGuard */
+#endif /* _AMR_H_ */
+/** \endcond */
@@ -0,0 +1,149 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  amr_main.c
+ \brief Adaptive mesh refinement implementation of semi-infinite diffusion equation
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "amr.h"
+#include "numerics.h"
+#include "output.h"
+#include "timer.h"
+
+/**
+ \brief Run simulation on a two-level composite grid using input parameters specified on the command line
+
+ Program will write a series of PNG image files of the rasterized composite
+ solution, plus a final CSV raw data file and CSV runtime log tabulating the
+ iteration counter (\a iter), elapsed simulation time (\a sim_time), error
+ relative to analytical solution (\a wrss), time spent in stencil sweeps over
+ both levels (\a sweep_time), time spent on boundary conditions, halos, and
+ regridding (\a sync_time), time spent writing to disk (\a IO_time), time spent
+ generating analytical values (\a soln_time), total elapsed (\a run_time),
+ the number of refined blocks (\a blocks), the fraction of the domain they
+ cover (\a refined), and the values stored by both levels relative to the
+ uniform mesh (\a storage). The optional key \a ag sets the refinement
+ threshold, see amr_regrid(), and \a ar the number of steps between regrids.
+*/
+int main(int argc, char* argv[])
+{
+	FILE * output;
+
+	/* declare default mesh size and resolution */
+	fp_t **conc, **conc_lap;
+	struct AMR amr;
+	int bx=32, by=32, nx=512, ny=512, nm=3, code=53;
+	fp_t dx=0.5, dy=0.5, h;
+
+	/* declare default materials and numerical parameters */
+	fp_t D=0.00625, linStab=0.1, dt=1., elapsed=0., rss=0.;
+	fp_t threshold=0.01;
+	int step=0, steps=100000, checks=10000, regrid=100;
+	fp_t regrid_time=0., file_time=0., soln_time=0.;
+
+	StartTimer();
+
+	param_parser(argc, argv, &bx, &by, &checks, &code, &D, &dx, &dy, &linStab, &nm, &nx, &ny, &steps);
+	param_optional_fp(argc, argv, "ag", &threshold);
+	param_optional_int(argc, argv, "ar", &regrid);
+	if (regrid < 1) {
+		printf("Error: regrid interval %i must be positive.\n", regrid);
+		exit(-1);
+	}
+
+	/* both levels take the step limited by the fine spacing */
+	h = (dx > dy) ? dy : dx;
+	dt = (linStab * h * h) / (4.0 * D);
+
+	/* initialize memory: blocks are the convolution block size */
+	make_amr(&amr, nx, ny, bx, by, nm, dx, dy, code, threshold);
+
+	print_progress(0, steps);
+
+	timer_push("initial conditions");
+	amr_initial_conditions(&amr);
+	timer_pop();
+
+	/* prepare to log comparison to analytical solution */
+	output = fopen("runlog.csv", "w");
+	if (output == NULL) {
+		printf("Error: unable to %s for output. Check permissions.\n", "runlog.csv");
+		exit(-1);
+	}
+
+	fprintf(output, "iter,sim_time,wrss,sweep_time,sync_time,IO_time,soln_time,run_time,blocks,refined,storage\n");
+	fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f,%i,%f,%f\n", step, elapsed, rss,
+	        amr.sweep_time, amr.sync_time + regrid_time, file_time, soln_time, GetTimer(),
+	        amr.nactive, (fp_t)amr.nactive / (amr.nbx * amr.nby),
+	        (fp_t)amr_cells(&amr) / (3.0 * nx * ny));
+
+	/* write initial condition data; the uniform raster exists only while writing */
+	timer_push("write_png");
+	conc = amr_make_field(nx, ny);
+	amr_rasterize(&amr, conc);
+	write_png(conc, nx, ny, 0);
+	amr_free_field(conc);
+	file_time += timer_pop();
+
+	/* do the work */
+	for (step = 1; step < steps+1; step++) {
+		print_progress(step, steps);
+
+		/* === Start Architecture-Specific Kernel === */
+		if (step % regrid == 0) {
+			timer_push("regrid");
+			amr_regrid(&amr);
+			regrid_time += timer_pop();
+		}
+
+		timer_push("timestep");
+		amr_step(&amr, D, dt);
+		timer_pop();
+		elapsed += dt;
+		/* === Finish Architecture-Specific Kernel === */
+
+		if (step % checks == 0) {
+			timer_push("write_png");
+			conc = amr_make_field(nx, ny);
+			conc_lap = amr_make_field(nx, ny);
+			amr_rasterize(&amr, conc);
+			write_png(conc, nx, ny, step);
+			file_time += timer_pop();
+
+			timer_push("check_solution");
+			check_solution(conc, conc_lap, nx, ny, dx, dy, nm, elapsed, D, &rss);
+			soln_time += timer_pop();
+
+			amr_free_field(conc);
+			amr_free_field(conc_lap);
+
+			fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f,%i,%f,%f\n", step, elapsed, rss,
+			        amr.sweep_time, amr.sync_time + regrid_time, file_time, soln_time, GetTimer(),
+			        amr.nactive, (fp_t)amr.nactive / (amr.nbx * amr.nby),
+			        (fp_t)amr_cells(&amr) / (3.0 * nx * ny));
+			fflush(output);
+		}
+	}
+
+	conc = amr_make_field(nx, ny);
+	amr_rasterize(&amr, conc);
+	write_csv(conc, nx, ny, dx, dy, steps);
+	amr_free_field(conc);
+
+	printf("AMR: %i of %i blocks refined, %ld values stored (%.1f%% of uniform): wrss %g at sim_time %g in %f s\n",
+	       amr.nactive, amr.nbx * amr.nby, amr_cells(&amr),
+	       100. * amr_cells(&amr) / (3.0 * nx * ny), rss, elapsed, GetTimer());
+	timer_report(stdout);
+
+	/* clean up */
+	fclose(output);
+	free_amr(&amr);
+
+	return 0;
+}
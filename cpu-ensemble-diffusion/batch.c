@@ -0,0 +1,227 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  batch.c
+ \brief Implementation of batched (SIMD-across-members) ensemble kernels
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "mesh.h"
+#include "numerics.h"
+#include "timer.h"
+
+/**
+ \brief Address of lane 0 of mesh point (\a i, \a j)
+*/
+#define LANES(conc, i, j) ((conc) + ((size_t)(j) * nx + (i)) * BATCH_WIDTH)
+
+int make_batches(const struct Member* members, const int n, struct Batch** batches)
+{
+	int* assigned = (int*)calloc(n, sizeof(int));
+	int nb = 0;
+
+	*batches = (struct Batch*)malloc(n * sizeof(struct Batch));
+
+	for (int first = 0; first < n; first++) {
+		struct Batch* batch;
+
+		if (assigned[first])
+			continue;
+
+		/* gather up to BATCH_WIDTH unassigned members sharing this resolution */
+		batch = &(*batches)[nb++];
+		batch->width = 0;
+		batch->dx = members[first].dx;
+		batch->dy = members[first].dy;
+		for (int m = first; m < n && batch->width < BATCH_WIDTH; m++) {
+			if (!assigned[m] && members[m].dx == batch->dx && members[m].dy == batch->dy) {
+				batch->member[batch->width++] = m;
+				assigned[m] = 1;
+			}
+		}
+
+		for (int l = 0; l < BATCH_WIDTH; l++) {
+			const struct Member* member = &members[batch->member[(l < batch->width) ? l : batch->width - 1]];
+			batch->D[l] = member->D;
+			batch->dt[l] = member->dt;
+			batch->Ddt[l] = member->D * member->dt;
+		}
+		batch->conc_old = batch->conc_new = batch->conc_lap = NULL;
+	}
+
+	free(assigned);
+	return nb;
+}
+
+void free_batches(struct Batch* batches)
+{
+	free(batches);
+}
+
+void batch_initial_conditions(fp_t* conc, const int nx, const int ny, const int nm)
+{
+	for (int j = 0; j < ny; j++) {
+		for (int i = 0; i < nx; i++) {
+			const int wall = (j < ny/2 && i < 1+nm/2) || (j >= ny/2 && i >= nx-1-nm/2);
+			fp_t* c = LANES(conc, i, j);
+			for (int l = 0; l < BATCH_WIDTH; l++)
+				c[l] = wall ? 1.0 : 0.0;
+		}
+	}
+}
+
+void batch_boundary_conditions(fp_t* conc, const int nx, const int ny, const int nm)
+{
+	/* apply fixed boundary values: sequence does not matter */
+
+	for (int j = 0; j < ny/2; j++)
+		for (int i = 0; i < 1+nm/2; i++)
+			for (int l = 0; l < BATCH_WIDTH; l++)
+				LANES(conc, i, j)[l] = 1.0; /* left value */
+
+	for (int j = ny/2; j < ny; j++)
+		for (int i = nx-1-nm/2; i < nx; i++)
+			for (int l = 0; l < BATCH_WIDTH; l++)
+				LANES(conc, i, j)[l] = 1.0; /* right value */
+
+	/* apply no-flux boundary conditions: inside to out, sequence matters */
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		for (int j = 0; j < ny; j++) {
+			memcpy(LANES(conc, ilo-1, j), LANES(conc, ilo, j), BATCH_WIDTH * sizeof(fp_t)); /* left condition */
+			memcpy(LANES(conc, ihi+1, j), LANES(conc, ihi, j), BATCH_WIDTH * sizeof(fp_t)); /* right condition */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		memcpy(LANES(conc, 0, jlo-1), LANES(conc, 0, jlo), (size_t)nx * BATCH_WIDTH * sizeof(fp_t)); /* bottom condition */
+		memcpy(LANES(conc, 0, jhi+1), LANES(conc, 0, jhi), (size_t)nx * BATCH_WIDTH * sizeof(fp_t)); /* top condition */
+	}
+}
+
+void batch_convolution(fp_t* conc_old, fp_t* conc_lap, fp_t** mask_lap,
+                       const int nx, const int ny, const int nm)
+{
+	for (int j = nm/2; j < ny-nm/2; j++) {
+		for (int i = nm/2; i < nx-nm/2; i++) {
+			fp_t value[BATCH_WIDTH] = {0.};
+			for (int mj = -nm/2; mj < nm/2+1; mj++) {
+				for (int mi = -nm/2; mi < nm/2+1; mi++) {
+					const fp_t w = mask_lap[mj+nm/2][mi+nm/2];
+					const fp_t* c = LANES(conc_old, i+mi, j+mj);
+					#ifdef _OPENMP
+					#pragma omp simd
+					#endif
+					for (int l = 0; l < BATCH_WIDTH; l++)
+						value[l] += w * c[l];
+				}
+			}
+			memcpy(LANES(conc_lap, i, j), value, BATCH_WIDTH * sizeof(fp_t));
+		}
+	}
+}
+
+void batch_update(fp_t* conc_old, fp_t* conc_lap, fp_t* conc_new,
+                  const int nx, const int ny, const int nm, const fp_t* Ddt)
+{
+	for (int j = nm/2; j < ny-nm/2; j++) {
+		for (int i = nm/2; i < nx-nm/2; i++) {
+			const fp_t* old = LANES(conc_old, i, j);
+			const fp_t* lap = LANES(conc_lap, i, j);
+			fp_t* next = LANES(conc_new, i, j);
+			#ifdef _OPENMP
+			#pragma omp simd
+			#endif
+			for (int l = 0; l < BATCH_WIDTH; l++)
+				next[l] = old[l] + Ddt[l] * lap[l];
+		}
+	}
+}
+
+void batch_check_solution(fp_t* conc, const int nx, const int ny, const fp_t dx, const fp_t dy,
+                          const int nm, const fp_t* elapsed, const fp_t* D, fp_t* rss)
+{
+	for (int l = 0; l < BATCH_WIDTH; l++)
+		rss[l] = 0.;
+
+	for (int j = nm/2; j < ny-nm/2; j++) {
+		for (int i = nm/2; i < nx-nm/2; i++) {
+			/* distances to the sources are shared by every lane */
+			const fp_t rl = distance_point_to_segment(dx * (nm/2), dy * (nm/2),
+			                                          dx * (nm/2), dy * (ny/2),
+			                                          dx * i, dy * j);
+			const fp_t rr = distance_point_to_segment(dx * (nx-1-nm/2), dy * (ny/2),
+			                                          dx * (nx-1-nm/2), dy * (ny-1-nm/2),
+			                                          dx * i, dy * j);
+			const fp_t* c = LANES(conc, i, j);
+			for (int l = 0; l < BATCH_WIDTH; l++) {
+				fp_t cal, car;
+				analytical_value(rl, elapsed[l], D[l], &cal);
+				analytical_value(rr, elapsed[l], D[l], &car);
+				rss[l] += (cal + car - c[l]) * (cal + car - c[l]) / (fp_t)((nx-1-nm/2) * (ny-1-nm/2));
+			}
+		}
+	}
+}
+
+void run_batch(struct Batch* batch, struct Member* members, const int nx, const int ny,
+               const int nm, const int code, const int steps, const int checks)
+{
+	const size_t bytes = (size_t)nx * ny * BATCH_WIDTH * sizeof(fp_t);
+	const double start_time = GetTimer();
+	fp_t **mask_lap, *temp;
+	fp_t elapsed[BATCH_WIDTH] = {0.};
+	fp_t rss[BATCH_WIDTH];
+
+	timer_push("batch");
+
+	batch->conc_old = (fp_t*)calloc(1, bytes);
+	batch->conc_new = (fp_t*)calloc(1, bytes);
+	batch->conc_lap = (fp_t*)calloc(1, bytes);
+	mask_lap = (fp_t**)calloc(nm, sizeof(fp_t*));
+	mask_lap[0] = (fp_t*)calloc(nm * nm, sizeof(fp_t));
+	for (int j = 1; j < nm; j++)
+		mask_lap[j] = &(mask_lap[0][nm * j]);
+	set_mask(batch->dx, batch->dy, code, mask_lap, nm);
+
+	batch_initial_conditions(batch->conc_old, nx, ny, nm);
+
+	for (int step = 1; step < steps+1; step++) {
+		batch_boundary_conditions(batch->conc_old, nx, ny, nm);
+		batch_convolution(batch->conc_old, batch->conc_lap, mask_lap, nx, ny, nm);
+		batch_update(batch->conc_old, batch->conc_lap, batch->conc_new, nx, ny, nm, batch->Ddt);
+
+		temp = batch->conc_old;
+		batch->conc_old = batch->conc_new;
+		batch->conc_new = temp;
+		for (int l = 0; l < BATCH_WIDTH; l++)
+			elapsed[l] += batch->dt[l];
+
+		if (step % checks == 0) {
+			batch_check_solution(batch->conc_old, nx, ny, batch->dx, batch->dy, nm, elapsed, batch->D, rss);
+			for (int l = 0; l < batch->width; l++) {
+				members[batch->member[l]].rss[step / checks] = rss[l];
+				members[batch->member[l]].runtime[step / checks] = GetTimer() - start_time;
+			}
+		}
+	}
+
+	free(batch->conc_old);
+	free(batch->conc_new);
+	free(batch->conc_lap);
+	free(mask_lap[0]);
+	free(mask_lap);
+	batch->conc_old = batch->conc_new = batch->conc_lap = NULL;
+
+	timer_pop();
+}
@@ -0,0 +1,113 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  batch.h
+ \brief Declaration of batched (SIMD-across-members) ensemble kernels
+*/
+
+/** \cond SuppressGuard */
+#ifndef _BATCH_H_
+#define _BATCH_H_
+/** \endcond */
+
+#include "ensemble.h"
+#include "type.h"
+
+/**
+ \brief Members per batch: one 512-bit vector of doubles, or two 256-bit
+*/
+#define BATCH_WIDTH 8
+
+/**
+ \brief Fields of up to #BATCH_WIDTH members, interleaved point by point
+
+ Value (\a i, \a j) of lane \a m is \c data[(j * nx + i) * BATCH_WIDTH + m],
+ so the lanes of one mesh point are contiguous. Because every lane shares
+ the mesh and the mask, each stencil coefficient multiplies a whole vector
+ of members: the convolution vectorizes across the ensemble with unit-stride
+ loads and no shuffles, whatever the mask size. Only the update, which
+ scales by each member's \f$ D\,\Delta t\f$, differs from lane to lane.
+*/
+struct Batch {
+	/**
+	 Number of members in use; unused lanes repeat the last member
+	*/
+	int width;
+
+	/**
+	 Index of each lane's member in the ensemble
+	*/
+	int member[BATCH_WIDTH];
+
+	/**
+	 Per-lane diffusivity, timestep, and their product
+	*/
+	fp_t D[BATCH_WIDTH], dt[BATCH_WIDTH], Ddt[BATCH_WIDTH];
+
+	/**
+	 Shared mesh resolution
+	*/
+	fp_t dx, dy;
+
+	/**
+	 Interleaved fields
+	*/
+	fp_t *conc_old, *conc_new, *conc_lap;
+};
+
+/**
+ \brief Group members with equal \a dx and \a dy into batches
+
+ Returns the number of batches, storing them in newly allocated \a batches.
+*/
+int make_batches(const struct Member* members, const int n, struct Batch** batches);
+
+/**
+ \brief Run every lane of a batch to completion, recording each member's
+ residual and runtime at each checkpoint
+*/
+void run_batch(struct Batch* batch, struct Member* members, const int nx, const int ny,
+               const int nm, const int code, const int steps, const int checks);
+
+/**
+ \brief Free batch array
+*/
+void free_batches(struct Batch* batches);
+
+/**
+ \brief Initialize every lane, as apply_initial_conditions()
+*/
+void batch_initial_conditions(fp_t* conc, const int nx, const int ny, const int nm);
+
+/**
+ \brief Apply boundary conditions to every lane, as apply_boundary_conditions()
+*/
+void batch_boundary_conditions(fp_t* conc, const int nx, const int ny, const int nm);
+
+/**
+ \brief Convolve every lane with the shared mask, as compute_convolution()
+*/
+void batch_convolution(fp_t* conc_old, fp_t* conc_lap, fp_t** mask_lap,
+                       const int nx, const int ny, const int nm);
+
+/**
+ \brief Forward-Euler update with per-lane \f$ D\,\Delta t\f$, as update_composition()
+*/
+void batch_update(fp_t* conc_old, fp_t* conc_lap, fp_t* conc_new,
+                  const int nx, const int ny, const int nm, const fp_t* Ddt);
+
+/**
+ \brief Residual of every lane against its own analytical solution
+
+ Each lane has its own diffusivity and elapsed time; \a rss receives one
+ value per lane, as check_solution() would compute for that member alone.
+*/
+void batch_check_solution(fp_t* conc, const int nx, const int ny, const fp_t dx, const fp_t dy,
+                          const int nm, const fp_t* elapsed, const fp_t* D, fp_t* rss);
+
+/** \cond SuppressGuard */
+#endif /* _BATCH_H_ */
+/** \endcond */
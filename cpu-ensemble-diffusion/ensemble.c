@@ -0,0 +1,176 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  ensemble.c
+ \brief Implementation of ensemble (parameter study) functions for diffusion benchmarks
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "boundaries.h"
+#include "ensemble.h"
+#include "mesh.h"
+#include "numerics.h"
+#include "timer.h"
+
+/**
+ \brief Largest number of columns in the parameter table
+*/
+#define MAX_COLUMNS 4
+
+/**
+ \brief Address of the member parameter named by \a key, or NULL
+*/
+static fp_t* member_parameter(struct Member* member, const char* key)
+{
+	if (strcmp(key, "dc") == 0)
+		return &member->D;
+	if (strcmp(key, "dx") == 0)
+		return &member->dx;
+	if (strcmp(key, "dy") == 0)
+		return &member->dy;
+	if (strcmp(key, "co") == 0)
+		return &member->linStab;
+	return NULL;
+}
+
+int read_ensemble(const char* filename, const struct Member* defaults, struct Member** members)
+{
+	FILE* input;
+	char buffer[256];
+	char columns[MAX_COLUMNS][3];
+	int ncols = -1, n = 0, capacity = 16;
+	const char* delims = " \t\r\n";
+
+	input = fopen(filename, "r");
+	if (input == NULL) {
+		printf("Error: unable to open ensemble table %s.\n", filename);
+		exit(-1);
+	}
+
+	*members = (struct Member*)malloc(capacity * sizeof(struct Member));
+
+	while (fgets(buffer, 256, input) != NULL) {
+		char* pch = strtok(buffer, delims);
+
+		if (pch == NULL || pch[0] == '#')
+			continue;
+
+		if (ncols < 0) {
+			/* header: one parameter key per column */
+			struct Member probe = *defaults;
+			for (ncols = 0; pch != NULL && pch[0] != '#'; pch = strtok(NULL, delims), ncols++) {
+				if (ncols == MAX_COLUMNS || member_parameter(&probe, pch) == NULL) {
+					printf("Error: ensemble column %s is not one of dc, dx, dy, co.\n", pch);
+					exit(-1);
+				}
+				strncpy(columns[ncols], pch, 2);
+				columns[ncols][2] = '\0';
+			}
+			continue;
+		}
+
+		if (n == capacity) {
+			capacity *= 2;
+			*members = (struct Member*)realloc(*members, capacity * sizeof(struct Member));
+		}
+
+		(*members)[n] = *defaults;
+		for (int c = 0; c < ncols; c++, pch = strtok(NULL, delims)) {
+			if (pch == NULL || pch[0] == '#') {
+				printf("Error: ensemble member %i has %i of %i columns.\n", n, c, ncols);
+				exit(-1);
+			}
+			*member_parameter(&(*members)[n], columns[c]) = atof(pch);
+		}
+		n++;
+	}
+
+	fclose(input);
+
+	if (n == 0) {
+		printf("Error: ensemble table %s defines no members.\n", filename);
+		exit(-1);
+	}
+
+	return n;
+}
+
+void prepare_ensemble(struct Member* members, const int n, const int steps, const int checks)
+{
+	for (int m = 0; m < n; m++) {
+		const fp_t h = (members[m].dx > members[m].dy) ? members[m].dy : members[m].dx;
+		members[m].dt = (members[m].linStab * h * h) / (4.0 * members[m].D);
+		members[m].rss = (fp_t*)calloc(steps / checks + 1, sizeof(fp_t));
+		members[m].runtime = (fp_t*)calloc(steps / checks + 1, sizeof(fp_t));
+	}
+}
+
+void run_member(struct Member* member, const int nx, const int ny, const int nm,
+                const int code, const int steps, const int checks)
+{
+	fp_t **conc_old, **conc_new, **conc_lap, **mask_lap;
+	fp_t elapsed = 0.;
+	const double start_time = GetTimer();
+
+	timer_push("member");
+
+	make_arrays(&conc_old, &conc_new, &conc_lap, &mask_lap, nx, ny, nm);
+	set_mask(member->dx, member->dy, code, mask_lap, nm);
+	apply_initial_conditions(conc_old, nx, ny, nm);
+
+	for (int step = 1; step < steps+1; step++) {
+		apply_boundary_conditions(conc_old, nx, ny, nm);
+		compute_convolution(conc_old, conc_lap, mask_lap, nx, ny, nm);
+		update_composition(conc_old, conc_lap, conc_new, nx, ny, nm, member->D, member->dt);
+		swap_pointers(&conc_old, &conc_new);
+		elapsed += member->dt;
+
+		if (step % checks == 0) {
+			check_solution(conc_old, conc_lap, nx, ny, member->dx, member->dy, nm,
+			               elapsed, member->D, &member->rss[step / checks]);
+			member->runtime[step / checks] = GetTimer() - start_time;
+		}
+	}
+
+	free_arrays(conc_old, conc_new, conc_lap, mask_lap);
+
+	timer_pop();
+}
+
+void write_ensemble(const char* filename, const struct Member* members, const int n,
+                    const int steps, const int checks)
+{
+	FILE* output;
+
+	output = fopen(filename, "w");
+	if (output == NULL) {
+		printf("Error: unable to open %s for output. Check permissions.\n", filename);
+		exit(-1);
+	}
+
+	fprintf(output, "member,dc,dx,dy,co,dt,iter,sim_time,wrss,run_time\n");
+	for (int m = 0; m < n; m++) {
+		for (int c = 0; c < steps / checks + 1; c++) {
+			fprintf(output, "%i,%f,%f,%f,%f,%f,%i,%f,%f,%f\n", m,
+			        members[m].D, members[m].dx, members[m].dy, members[m].linStab, members[m].dt,
+			        c * checks, c * checks * members[m].dt, members[m].rss[c],
+			        members[m].runtime[c]);
+		}
+	}
+
+	fclose(output);
+}
+
+void free_ensemble(struct Member* members, const int n)
+{
+	for (int m = 0; m < n; m++) {
+		free(members[m].rss);
+		free(members[m].runtime);
+	}
+	free(members);
+}
@@ -0,0 +1,85 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  ensemble.h
+ \brief Declaration of ensemble (parameter study) functions for diffusion benchmarks
+*/
+
+/** \cond SuppressGuard */
+#ifndef _ENSEMBLE_H_
+#define _ENSEMBLE_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief One independent simulation in an ensemble, and its results
+
+ Every member shares the mesh size, mask, step count, and checkpoint
+ interval read from the parameter file; \a D, \a dx, \a dy, and \a linStab
+ may vary from member to member.
+*/
+struct Member {
+	/**
+	 Diffusivity, mesh resolution, and linear stability constant
+	*/
+	fp_t D, dx, dy, linStab;
+
+	/**
+	 Timestep, \f$ \Delta t = \textrm{co}\, h^2 / 4D \f$ with \f$ h = \min(dx, dy)\f$
+	*/
+	fp_t dt;
+
+	/**
+	 Weighted residual sum of squares at each checkpoint
+	*/
+	fp_t* rss;
+
+	/**
+	 Wall time since this member began, in seconds, at each checkpoint
+	*/
+	fp_t* runtime;
+};
+
+/**
+ \brief Read ensemble members from a whitespace-delimited parameter table
+
+ The first line that is neither blank nor a comment (\#) names the columns
+ using the parameter-file keys \a dc, \a dx, \a dy, and \a co, in any order
+ and any subset. Each following line defines one member; parameters without
+ a column take their value from \a defaults. Returns the number of members,
+ storing them in newly allocated \a members.
+*/
+int read_ensemble(const char* filename, const struct Member* defaults, struct Member** members);
+
+/**
+ \brief Allocate checkpoint storage and compute the timestep of each member
+*/
+void prepare_ensemble(struct Member* members, const int n, const int steps, const int checks);
+
+/**
+ \brief Run one member to completion, recording its residual at each checkpoint
+
+ Fields are private to the member, so members may run concurrently on
+ different threads.
+*/
+void run_member(struct Member* member, const int nx, const int ny, const int nm,
+                const int code, const int steps, const int checks);
+
+/**
+ \brief Write every member's checkpoints to one CSV file, in member order
+*/
+void write_ensemble(const char* filename, const struct Member* members, const int n,
+                    const int steps, const int checks);
+
+/**
+ \brief Free checkpoint storage and the member array
+*/
+void free_ensemble(struct Member* members, const int n);
+
+/** \cond SuppressGuard */
+#endif /* _ENSEMBLE_H_ */
+/** \endcond */
@@ -4,8 +4,8 @@
 
 #include "DiffOpTask.h"
 
-DiffOpTask::DiffOpTask(size_t numThreads, fp_t ***conc_old, fp_t ***conc_new, fp_t **mask_lap, fp_t **conc_lap, fp_t D, fp_t dt, int nm, int nbx, int nby)
-    : hh::AbstractTask<GridPtrData, GridPtrData>("DiffOpTask", numThreads), conc_old(conc_old), conc_new(conc_new), mask_lap(mask_lap), conc_lap(conc_lap), D(D), dt(dt), nm(nm), nbx(nbx), nby(nby) {}
+DiffOpTask::DiffOpTask(size_t numThreads, fp_t ***conc_old, fp_t ***conc_new, fp_t **mask_lap, fp_t **conc_lap, fp_t D, fp_t dt, int nm, int nbx, int nby, fp_t *change)
+    : hh::AbstractTask<GridPtrData, GridPtrData>("DiffOpTask", numThreads), conc_old(conc_old), conc_new(conc_new), mask_lap(mask_lap), conc_lap(conc_lap), D(D), dt(dt), nm(nm), nbx(nbx), nby(nby), change(change) {}
 
 void DiffOpTask::execute(std::shared_ptr<GridPtrData> data) {
 
@@ -26,12 +26,15 @@ void DiffOpTask::execute(std::shared_ptr<GridPtrData> data) {
   // nx and ny should be the width and height of the block
   compute_convolution(*conc_old, conc_lap, mask_lap, i, j, nx, ny, nm);
 
-  update_composition(*conc_old, conc_lap, *conc_new, i, j, nx, ny, nm, D, dt);
+  const fp_t largest = update_composition(*conc_old, conc_lap, *conc_new, i, j, nx, ny, nm, D, dt);
+
+  // each block is written by one task, so the main thread may read this once all results are in
+  change[blockIdy * nbx + blockIdx] = largest;
   addResult(data);
 }
 
 std::shared_ptr<hh::AbstractTask<GridPtrData, GridPtrData>> DiffOpTask::copy() {
-  return std::make_shared<DiffOpTask>(this->numberThreads(), this->getConc_old(), this->getConc_new(), this->getMask_lap(), this->getConc_lap(), this->getD(), this->getDt(), this->getNm(), this->getNbx(), this->getNby());
+  return std::make_shared<DiffOpTask>(this->numberThreads(), this->getConc_old(), this->getConc_new(), this->getMask_lap(), this->getConc_lap(), this->getD(), this->getDt(), this->getNm(), this->getNbx(), this->getNby(), this->getChange());
 }
 
 int DiffOpTask::getNbx() const {
@@ -42,6 +45,10 @@ int DiffOpTask::getNby() const {
   return nby;
 }
 
+fp_t *DiffOpTask::getChange() const {
+  return change;
+}
+
 fp_t **DiffOpTask::getMask_lap() const {
   return mask_lap;
 }
@@ -6,13 +6,16 @@
 #define HIPERC_HTGS_DIFFOPTASK_H
 
 
+#include <algorithm>
+#include <cmath>
 #include <hedgehog/hedgehog.h>
 #include "../data/GridPtrData.h"
 #include "../utils/type.h"
+#include "../../common-diffusion/stencil.h"
 
 class DiffOpTask : public hh::AbstractTask<GridPtrData, GridPtrData> {
 public:
-  DiffOpTask(size_t numThreads, fp_t ***conc_old, fp_t ***conc_new, fp_t **mask_lap, fp_t **conc_lap, fp_t D, fp_t dt, int nm, int nbx, int nby);
+  DiffOpTask(size_t numThreads, fp_t ***conc_old, fp_t ***conc_new, fp_t **mask_lap, fp_t **conc_lap, fp_t D, fp_t dt, int nm, int nbx, int nby, fp_t *change);
 
   void execute(std::shared_ptr<GridPtrData> data) override;
 
@@ -37,6 +40,8 @@ public:
 
   int getNby() const;
 
+  fp_t *getChange() const;
+
 
 private:
 
@@ -49,32 +54,32 @@ private:
   fp_t D;
   fp_t dt;
 
+  // Largest change of each block in its last update, indexed blockIdy * nbx + blockIdx
+  fp_t *change;
+
   void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
                            int startI, int startJ, const int nx, const int ny, const int nm)
   {
-
-    for (int j = startJ; j < ny; j++) {
-      for (int i = startI; i < nx; i++) {
-        fp_t value = 0.0;
-        for (int mj = -nm/2; mj < nm/2+1; mj++) {
-          for (int mi = -nm/2; mi < nm/2+1; mi++) {
-            value += mask_lap[mj+nm/2][mi+nm/2] * conc_old[j+mj][i+mi];
-          }
-        }
-        conc_lap[j][i] = value;
-      }
-    }
+    // one block of the shared stencil front end, swept by this task's thread
+    const stencil::Box block = {startI, nx, startJ, ny};
+    stencil::sweep(block, [=](const int i, const int j) {
+      conc_lap[j][i] = stencil::laplacian(conc_old, mask_lap, nm, i, j);
+    });
   }
 
-  void update_composition(fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
+  fp_t update_composition(fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
                           int startI, int startJ, const int nx, const int ny, const int nm,
                           const fp_t D, const fp_t dt)
   {
+    fp_t largest = 0.0;
     for (int j = startJ; j < ny; j++) {
       for (int i = startI; i < nx; i++) {
-        conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
+        const fp_t delta = dt * D * conc_lap[j][i];
+        conc_new[j][i] = conc_old[j][i] + delta;
+        largest = std::max(largest, std::fabs(delta));
       }
     }
+    return largest;
   }
 
 
@@ -37,6 +37,13 @@ void param_parser(int argc, char *argv[], int *bx, int *by,
                   fp_t *linStab, int *nm, int *nx, int *ny, int *steps);
 
 
+/**
+ \brief Read an optional floating-point parameter from the file specified on the command line
+
+ If \a key is absent, \a value keeps its default.
+*/
+void param_optional_fp(int argc, char* argv[], const char* key, fp_t* value);
+
 /**
  \brief Prints timestamps and a 20-point progress bar to stdout
 
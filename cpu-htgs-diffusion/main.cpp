@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 #include <htgs/api/TaskGraphConf.hpp>
 #include <htgs/api/TaskGraphRuntime.hpp>
 #include "data/GridPtrData.h"
@@ -7,37 +10,21 @@
 #include "utils/output.h"
 #include "utils/mesh.h"
 #include "utils/numerics.h"
+#include "../common-diffusion/stencil.h"
 #define USE_HTGS
 void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
                          const int nx, const int ny, const int nm)
 {
-  int i;
-  int j;
-  for (j = nm/2; j < ny-nm/2; j++) {
-    for (i = nm/2; i < nx-nm/2; i++) {
-      fp_t value = 0.0;
-      for (int mj = -nm/2; mj < nm/2+1; mj++) {
-        for (int mi = -nm/2; mi < nm/2+1; mi++) {
-          value += mask_lap[mj+nm/2][mi+nm/2] * conc_old[j+mj][i+mi];
-        }
-      }
-      conc_lap[j][i] = value;
-    }
-  }
-//  std::cout << "i = " << i << " j = " << j << std::endl;
-
-
+  const stencil::Serial exec = {{nx, ny}};
+  stencil::convolve(exec, conc_old, conc_lap, mask_lap, nx, ny, nm);
 }
 
 void update_composition(fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
                         const int nx, const int ny, const int nm,
                         const fp_t D, const fp_t dt)
 {
-  for (int j = nm/2; j < ny-nm/2; j++) {
-    for (int i = nm/2; i < nx-nm/2; i++) {
-      conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
-    }
-  }
+  const stencil::Serial exec = {{nx, ny}};
+  stencil::update(exec, conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
 }
 
 
@@ -111,10 +98,19 @@ int main(int argc, char *argv[]) {
 
   param_parser(argc, argv, &bx, &by, &checks, &code, &D, &dx, &dy, &linStab,  &nm, &nx, &ny, &steps);
 
+  // Blocks whose neighborhood changed by no more than this in the last step are skipped
+  fp_t steady = -1.0;
+  param_optional_fp(argc, argv, "at", &steady);
+
 
   int nbx = nx / bx;
   int nby = ny / by;
 
+  // Largest change of each block in its last update; unknown at first, so every block wakes
+  std::vector<fp_t> change(nbx * nby, INFINITY);
+  std::vector<char> active(nbx * nby, 1);
+  long swept = 0, visited = 0;
+
   h = (dx > dy) ? dy : dx;
   dt = (linStab * h * h) / (4.0 * D);
 
@@ -136,8 +132,8 @@ int main(int argc, char *argv[]) {
 //  fprintf(output, "iter,sim_time,wrss,conv_time,step_time,IO_time,soln_time,  run_time\n");
 //  fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f\n", step, elapsed, rss,
 //          watch.conv, watch.step, watch.file, watch.soln, GetTimer());
-  fprintf(output, "iter,wrss,\n");
-  fprintf(output, "%i,%f\n", step, rss);
+  fprintf(output, "iter,wrss,active\n");
+  fprintf(output, "%i,%f,%f\n", step, rss, 1.0);
 
   fflush(output);
 
@@ -146,7 +142,7 @@ int main(int argc, char *argv[]) {
 #ifdef USE_HTGS
   size_t nThreadsDiff = 12;
 
-  auto diffOpTask = new DiffOpTask(nThreadsDiff, &conc_old, &conc_new, mask_lap, conc_lap, D, dt, nm, nbx, nby);
+  auto diffOpTask = new DiffOpTask(nThreadsDiff, &conc_old, &conc_new, mask_lap, conc_lap, D, dt, nm, nbx, nby, change.data());
 
   auto taskGraph = new htgs::TaskGraphConf<GridPtrData, GridPtrData>();
 
@@ -175,19 +171,37 @@ int main(int argc, char *argv[]) {
     compute_convolution(conc_old, conc_lap, mask_lap, nx, ny, nm);
     update_composition(conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
 #else
+    int pushed = 0;
     for (int i = 0; i < nby; i++)
     {
       for (int j = 0; j < nbx; j++)
       {
+        // A block can only change if it, or a neighbor whose values its stencil reads, changed last step
+        bool wake = steady < 0.0;
+        for (int di = -1; di < 2 && !wake; di++)
+          for (int dj = -1; dj < 2 && !wake; dj++)
+            if (i + di >= 0 && i + di < nby && j + dj >= 0 && j + dj < nbx)
+              wake = change[(i + di) * nbx + j + dj] > steady;
+
+        // A block going to sleep must leave identical values in both buffers
+        if (!wake && active[i * nbx + j])
+          for (int y = i * by; y < (i + 1) * by; y++)
+            std::copy(&conc_old[y][j * bx], &conc_old[y][(j + 1) * bx], &conc_new[y][j * bx]);
+        active[i * nbx + j] = wake;
+        if (!wake)
+          continue;
+
         // Produce data block-by-block
         taskGraph->produceData(new GridPtrData(j, i, bx, by));
-
+        pushed++;
       }
     }
+    swept += pushed;
+    visited += nby * nbx;
 
     int count = 0;
 
-    while (count < nby*nbx)
+    while (count < pushed)
     {
       taskGraph->consumeData();
       count++;
@@ -195,6 +209,15 @@ int main(int argc, char *argv[]) {
 #endif
 
     swap_pointers(&conc_old, &conc_new);
+    elapsed += dt;
+
+    if (step % checks == 0) {
+      check_solution(conc_old, conc_lap, nx, ny, dx, dy, nm, elapsed, D, &rss);
+      fprintf(output, "%i,%f,%f\n", step, rss, (visited > 0) ? (fp_t)swept / visited : 1.0);
+      fflush(output);
+      swept = 0;
+      visited = 0;
+    }
 
 //    if ((step % 100) == 0)
 //      write_png(conc_old, nx, ny, step);
@@ -131,7 +131,7 @@ void check_solution(fp_t** conc_new, fp_t** conc_lap, const int nx, const int ny
 	fp_t sum = 0.;
 	int i, j;
 
-	#ifdef __OPENMP
+	#ifdef _OPENMP
 	#pragma omp parallel reduction(+:sum)
 	{
 		#pragma omp for collapse(2) private (i,j)
@@ -163,7 +163,7 @@ void check_solution(fp_t** conc_new, fp_t** conc_lap, const int nx, const int ny
 			}
 		}
 
-		#ifdef __OPENMP
+		#ifdef _OPENMP
 		#pragma omp for collapse(2) private(i,j)
 		#endif
 		for (j = nm/2; j < ny-nm/2; j++) {
@@ -171,7 +171,7 @@ void check_solution(fp_t** conc_new, fp_t** conc_lap, const int nx, const int ny
 				sum += conc_lap[j][i];
 			}
 		}
-	#ifdef __OPENMP
+	#ifdef _OPENMP
 	}
 	#endif
 
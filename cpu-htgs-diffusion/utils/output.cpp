@@ -135,6 +135,32 @@ void param_parser(int argc, char* argv[], int* bx, int* by, int* checks, int* co
 	fclose(input);
 }
 
+void param_optional_fp(int argc, char* argv[], const char* key, fp_t* value)
+{
+	FILE * input;
+	char buffer[256];
+	char* pch;
+
+	if (argc != 2)
+		return;
+
+	input = fopen(argv[1], "r");
+	if (input == NULL)
+		return;
+
+	while (fgets(buffer, 256, input) != NULL) {
+		pch = strtok(buffer, " ");
+		if (pch != NULL && strcmp(pch, key) == 0) {
+			pch = strtok(NULL, " ");
+			if (pch != NULL)
+				*value = atof(pch);
+			break;
+		}
+	}
+
+	fclose(input);
+}
+
 void print_progress(const int step, const int steps)
 {
 	static unsigned long tstart;
@@ -9,18 +9,29 @@
 */
 
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <omp.h>
 #include "boundaries.h"
+#include "integrator.h"
 #include "mesh.h"
 #include "numerics.h"
+#include "openmp_march.h"
+#include "output.h"
+#include "tiles.h"
 #include "timer.h"
+#include "trace.h"
 
 void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
                          const int nx, const int ny, const int nm)
 {
 	#pragma omp parallel
 	{
-		#pragma omp for collapse(2)
+		const unsigned long long start = trace_begin();
+
+		/* nowait: the end of the parallel region is the barrier, so each
+		   thread's trace event ends when its own rows are done */
+		#pragma omp for collapse(2) nowait
 		for (int j = nm/2; j < ny-nm/2; j++) {
 			for (int i = nm/2; i < nx-nm/2; i++) {
 				fp_t value = 0.0;
@@ -32,6 +43,8 @@ void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
 				conc_lap[j][i] = value;
 			}
 		}
+
+		trace_end("convolution", -1, start);
 	}
 }
 
@@ -39,10 +52,321 @@ void update_composition(fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
 				   const int nx, const int ny, const int nm,
 				   const fp_t D, const fp_t dt)
 {
-	#pragma omp parallel for collapse(2)
-	for (int j = nm/2; j < ny - nm/2; j++) {
-		for (int i = nm/2; i < nx - nm/2; i++) {
-			conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
+	#pragma omp parallel
+	{
+		const unsigned long long start = trace_begin();
+
+		#pragma omp for collapse(2) nowait
+		for (int j = nm/2; j < ny - nm/2; j++) {
+			for (int i = nm/2; i < nx - nm/2; i++) {
+				conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
+			}
+		}
+
+		trace_end("update", -1, start);
+	}
+}
+
+void combine_stages(fp_t** out,
+                    const fp_t c0, fp_t** y0, const fp_t c1, fp_t** y1, const fp_t c2, fp_t** y2,
+                    const fp_t c3, fp_t** l0, const fp_t c4, fp_t** l1,
+                    const int nx, const int ny, const int nm)
+{
+	#pragma omp parallel
+	{
+		const unsigned long long start = trace_begin();
+
+		/* loop-invariant NULL tests are hoisted out by the compiler */
+		#pragma omp for collapse(2) nowait
+		for (int j = nm/2; j < ny - nm/2; j++) {
+			for (int i = nm/2; i < nx - nm/2; i++) {
+				fp_t value = 0.0;
+				if (y0 != NULL) value += c0 * y0[j][i];
+				if (y1 != NULL) value += c1 * y1[j][i];
+				if (y2 != NULL) value += c2 * y2[j][i];
+				if (l0 != NULL) value += c3 * l0[j][i];
+				if (l1 != NULL) value += c4 * l1[j][i];
+				out[j][i] = value;
+			}
+		}
+
+		trace_end("update", -1, start);
+	}
+}
+
+void compute_convolution_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                               fp_t** mask_lap, const int nm)
+{
+	const int ntx = conc_old->ntx;
+	const int ntiles = sweep_count(conc_old);
+
+	/* static schedule: each thread sweeps a contiguous run of tile order,
+	   active tiles only if conc_old tracks activity */
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < ntiles; k++) {
+		const int ti = sweep_tile(conc_old, k) % ntx;
+		const int tj = sweep_tile(conc_old, k) / ntx;
+		convolve_tile(conc_old, conc_lap, mask_lap, nm, ti, tj);
+	}
+}
+
+void update_composition_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                              struct Tiles* conc_new, const int nm,
+                              const fp_t D, const fp_t dt)
+{
+	const int ntx = conc_old->ntx;
+	const int ntiles = sweep_count(conc_old);
+
+	/* static schedule: each thread sweeps a contiguous run of tile order,
+	   active tiles only if conc_old tracks activity */
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < ntiles; k++) {
+		const int ti = sweep_tile(conc_old, k) % ntx;
+		const int tj = sweep_tile(conc_old, k) / ntx;
+		update_tile(conc_old, conc_lap, conc_new, nm, ti, tj, D, dt);
+	}
+}
+
+/**
+ \brief Apply boundary conditions to the part of \a conc owned by the tile spanning [\a x0, \a x1) by [\a y0, \a y1)
+
+ Tiles on the edge of the domain also own the halo beyond it, corners
+ included, so the union over tiles repeats apply_boundary_conditions() in
+ the same order: fixed values, then reflections along x, then along y.
+*/
+static void bound_tile(fp_t** conc, const int nx, const int ny, const int nm,
+                       const int x0, const int x1, const int y0, const int y1)
+{
+	const int ex0 = (x0 == nm/2) ? 0 : x0;
+	const int ex1 = (x1 == nx-nm/2) ? nx : x1;
+	const int ey0 = (y0 == nm/2) ? 0 : y0;
+	const int ey1 = (y1 == ny-nm/2) ? ny : y1;
+
+	for (int j = ey0; j < ey1; j++) {
+		for (int i = ex0; i < ex1; i++) {
+			if (j < ny/2 && i < 1+nm/2)
+				conc[j][i] = 1.; /* left value */
+			else if (j >= ny/2 && i >= nx-1-nm/2)
+				conc[j][i] = 1.; /* right value */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		for (int j = ey0; j < ey1; j++) {
+			if (x0 == nm/2)
+				conc[j][ilo-1] = conc[j][ilo]; /* left condition */
+			if (x1 == nx-nm/2)
+				conc[j][ihi+1] = conc[j][ihi]; /* right condition */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		for (int i = ex0; i < ex1; i++) {
+			if (y0 == nm/2)
+				conc[jlo-1][i] = conc[jlo][i]; /* bottom condition */
+			if (y1 == ny-nm/2)
+				conc[jhi+1][i] = conc[jhi][i]; /* top condition */
+		}
+	}
+}
+
+/**
+ \brief Convolve and update the tile spanning [\a x0, \a x1) by [\a y0, \a y1), summing as compute_convolution() does
+*/
+static void step_tile(fp_t** conc_old, fp_t** conc_new, fp_t** mask_lap, const int nm,
+                      const int x0, const int x1, const int y0, const int y1,
+                      const fp_t D, const fp_t dt)
+{
+	for (int j = y0; j < y1; j++) {
+		for (int i = x0; i < x1; i++) {
+			fp_t value = 0.0;
+			for (int mj = -nm/2; mj < nm/2+1; mj++) {
+				for (int mi = -nm/2; mi < nm/2+1; mi++) {
+					value += mask_lap[mj+nm/2][mi+nm/2] * conc_old[j+mj][i+mi];
+				}
+			}
+			conc_new[j][i] = conc_old[j][i] + dt * D * value;
+		}
+	}
+}
+
+void march_wavefront(fp_t*** conc_old, fp_t*** conc_new, fp_t** mask_lap,
+                     const int nx, const int ny, const int nm, const int bx, const int by,
+                     const fp_t D, const fp_t dt, const int steps, const int lookahead)
+{
+	const int ntx = (nx - 2 * (nm/2) + bx - 1) / bx;
+	const int nty = (ny - 2 * (nm/2) + by - 1) / by;
+	const int ntiles = ntx * nty;
+	const int ring = lookahead + 1;
+	fp_t** field[2] = {*conc_old, *conc_new};
+
+	/* Dependence tokens, one per tile and step modulo the ring. The bytes are
+	   never read: their addresses name the tasks that last wrote them. */
+	char* bounded = (char*)calloc(ring * ntiles, sizeof(char));
+	char* stepped = (char*)calloc(ring * ntiles, sizeof(char));
+
+	if (bx < nm/2 || by < nm/2) {
+		printf("Error: wavefront tiles of %i x %i are narrower than the halo of mask size %i.\n", bx, by, nm);
+		exit(-1);
+	}
+
+	#pragma omp parallel
+	#pragma omp single
+	{
+		for (int s = 0; s < steps; s++) {
+			fp_t** src = field[s % 2];
+			fp_t** dst = field[(s + 1) % 2];
+			const int now = (s % ring) * ntiles;
+			const int was = ((s + ring - 1) % ring) * ntiles;
+
+			/* keep at most lookahead steps of tasks in flight */
+			if (s >= lookahead) {
+				const int old = ((s - lookahead) % ring) * ntiles;
+				for (int t = 0; t < ntiles; t++) {
+					#pragma omp taskwait depend(in: stepped[old + t])
+				}
+			}
+
+			for (int tj = 0; tj < nty; tj++) {
+				for (int ti = 0; ti < ntx; ti++) {
+					const int t = ti + ntx * tj;
+					const int x0 = nm/2 + bx * ti;
+					const int y0 = nm/2 + by * tj;
+					const int x1 = (x0 + bx < nx-nm/2) ? x0 + bx : nx-nm/2;
+					const int y1 = (y0 + by < ny-nm/2) ? y0 + by : ny-nm/2;
+
+					/* boundary values of src on this tile, once the previous step wrote it */
+					if (s == 0) {
+						#pragma omp task depend(out: bounded[now + t])
+						bound_tile(src, nx, ny, nm, x0, x1, y0, y1);
+					} else {
+						#pragma omp task depend(in: stepped[was + t]) depend(out: bounded[now + t])
+						bound_tile(src, nx, ny, nm, x0, x1, y0, y1);
+					}
+				}
+			}
+
+			for (int tj = 0; tj < nty; tj++) {
+				for (int ti = 0; ti < ntx; ti++) {
+					const int t = ti + ntx * tj;
+					const int x0 = nm/2 + bx * ti;
+					const int y0 = nm/2 + by * tj;
+					const int x1 = (x0 + bx < nx-nm/2) ? x0 + bx : nx-nm/2;
+					const int y1 = (y0 + by < ny-nm/2) ? y0 + by : ny-nm/2;
+					const int w = (ti > 0) ? t - 1 : t;
+					const int e = (ti < ntx-1) ? t + 1 : t;
+					const int sw = (tj > 0) ? w - ntx : w;
+					const int so = (tj > 0) ? t - ntx : t;
+					const int se = (tj > 0) ? e - ntx : e;
+					const int nw = (tj < nty-1) ? w + ntx : w;
+					const int no = (tj < nty-1) ? t + ntx : t;
+					const int ne = (tj < nty-1) ? e + ntx : e;
+
+					/* the stencil reads src from all eight neighbors; dst was
+					   last read two steps ago, by tasks these already follow */
+					#pragma omp task depend(in: bounded[now + sw], bounded[now + so], bounded[now + se], \
+					                            bounded[now + w],  bounded[now + t],  bounded[now + e], \
+					                            bounded[now + nw], bounded[now + no], bounded[now + ne]) \
+					                 depend(out: stepped[now + t])
+					{
+						const unsigned long long start = trace_begin();
+						step_tile(src, dst, mask_lap, nm, x0, x1, y0, y1, D, dt);
+						trace_end("convolution", -1, start);
+					}
+				}
+			}
+		}
+	}
+
+	free(bounded);
+	free(stepped);
+
+	/* after an odd number of steps the newest field is in conc_new */
+	if (steps % 2 == 1)
+		swap_pointers(conc_old, conc_new);
+}
+
+void march_persistent(fp_t*** conc_old, fp_t*** conc_new, fp_t** conc_lap, fp_t** mask_lap,
+                      const int nx, const int ny, const int nm, const fp_t D, const fp_t dt,
+                      const int steps, const int first, const int total)
+{
+	#pragma omp parallel
+	{
+		/* every thread swaps its own copy of the field pointers */
+		fp_t** src = *conc_old;
+		fp_t** dst = *conc_new;
+
+		for (int s = 0; s < steps; s++) {
+			#pragma omp master
+			if (total > 0 && s > 0)
+				print_progress(first + s, total);
+
+			/* fixed values and reflections along x stay within their row */
+			#pragma omp for schedule(static)
+			for (int j = 0; j < ny; j++) {
+				if (j < ny/2) {
+					for (int i = 0; i < 1+nm/2; i++)
+						src[j][i] = 1.; /* left value */
+				} else {
+					for (int i = nx-1-nm/2; i < nx; i++)
+						src[j][i] = 1.; /* right value */
+				}
+				for (int offset = 0; offset < nm/2; offset++) {
+					const int ilo = nm/2 - offset;
+					const int ihi = nx - 1 - nm/2 + offset;
+					src[j][ilo-1] = src[j][ilo]; /* left condition */
+					src[j][ihi+1] = src[j][ihi]; /* right condition */
+				}
+			}
+
+			/* reflections along y read rows other threads finished above, and
+			   stay within their column */
+			#pragma omp for schedule(static)
+			for (int i = 0; i < nx; i++) {
+				for (int offset = 0; offset < nm/2; offset++) {
+					const int jlo = nm/2 - offset;
+					const int jhi = ny - 1 - nm/2 + offset;
+					src[jlo-1][i] = src[jlo][i]; /* bottom condition */
+					src[jhi+1][i] = src[jhi][i]; /* top condition */
+				}
+			}
+
+			const unsigned long long start = trace_begin();
+
+			/* nowait: the update below gives each thread the same rows */
+			#pragma omp for schedule(static) nowait
+			for (int j = nm/2; j < ny-nm/2; j++) {
+				for (int i = nm/2; i < nx-nm/2; i++) {
+					fp_t value = 0.0;
+					for (int mj = -nm/2; mj < nm/2+1; mj++) {
+						for (int mi = -nm/2; mi < nm/2+1; mi++) {
+							value += mask_lap[mj+nm/2][mi+nm/2] * src[j+mj][i+mi];
+						}
+					}
+					conc_lap[j][i] = value;
+				}
+			}
+
+			#pragma omp for schedule(static)
+			for (int j = nm/2; j < ny-nm/2; j++) {
+				for (int i = nm/2; i < nx-nm/2; i++) {
+					dst[j][i] = src[j][i] + dt * D * conc_lap[j][i];
+				}
+			}
+
+			trace_end("timestep", -1, start);
+
+			fp_t** temp = src;
+			src = dst;
+			dst = temp;
 		}
 	}
+
+	/* after an odd number of steps the newest field is in conc_new */
+	if (steps % 2 == 1)
+		swap_pointers(conc_old, conc_new);
 }
@@ -0,0 +1,50 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  openmp_march.h
+ \brief Declaration of OpenMP drivers that march several steps per parallel region
+*/
+
+/** \cond SuppressGuard */
+#ifndef _OPENMP_MARCH_H_
+#define _OPENMP_MARCH_H_
+/** \endcond */
+
+#include "type.h"
+
+/**
+ \brief March \a steps forward Euler steps as a graph of tile tasks, with no barrier between steps
+
+ Each \a bx by \a by tile applies its share of the boundary conditions, then
+ convolves and updates as an \c omp \c task whose \c depend clauses name its
+ neighbors from the previous step, so tiles run ahead of the slowest region
+ by up to \a lookahead steps. The newest field is returned in \a conc_old;
+ results match apply_boundary_conditions(), compute_convolution(), and
+ update_composition() step by step.
+*/
+void march_wavefront(fp_t*** conc_old, fp_t*** conc_new, fp_t** mask_lap,
+                     const int nx, const int ny, const int nm, const int bx, const int by,
+                     const fp_t D, const fp_t dt, const int steps, const int lookahead);
+
+/**
+ \brief March \a steps forward Euler steps inside a single parallel region
+
+ The team is forked once, not three times per step, and each step costs
+ three barriers: after the boundary rows, after the boundary columns, and
+ after the update. The convolution and update share a static schedule over
+ the same rows, so no barrier separates them. If \a total is positive, the
+ master thread calls print_progress() as it begins each step after the
+ first, numbering the first step \a first. The newest field is returned in \a conc_old; results match
+ apply_boundary_conditions(), compute_convolution(), and
+ update_composition() step by step.
+*/
+void march_persistent(fp_t*** conc_old, fp_t*** conc_new, fp_t** conc_lap, fp_t** mask_lap,
+                      const int nx, const int ny, const int nm, const fp_t D, const fp_t dt,
+                      const int steps, const int first, const int total);
+
+/** \cond SuppressGuard */
+#endif /* _OPENMP_MARCH_H_ */
+/** \endcond */
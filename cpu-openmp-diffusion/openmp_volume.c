@@ -0,0 +1,155 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  openmp_volume.c
+ \brief Implementation of 3D boundary condition and discretization functions with OpenMP threading
+*/
+
+#include <stdlib.h>
+#include <omp.h>
+#include "volume.h"
+
+void apply_initial_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm)
+{
+	#pragma omp parallel
+	{
+		#pragma omp for collapse(2)
+		for (int k = 0; k < nz; k++)
+			for (int j = 0; j < ny; j++)
+				for (int i = 0; i < nx; i++)
+					conc[k][j][i] = 0.0;
+
+		#pragma omp for collapse(2) nowait
+		for (int k = 0; k < nz/2; k++)
+			for (int j = 0; j < ny/2; j++)
+				for (int i = 0; i < 1+nm/2; i++)
+					conc[k][j][i] = 1.0; /* left quarter-wall */
+
+		#pragma omp for collapse(2)
+		for (int k = nz/2; k < nz; k++)
+			for (int j = ny/2; j < ny; j++)
+				for (int i = nx-1-nm/2; i < nx; i++)
+					conc[k][j][i] = 1.0; /* right quarter-wall */
+	}
+}
+
+void apply_boundary_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm)
+{
+	#pragma omp parallel
+	{
+		/* apply fixed boundary values: sequence does not matter */
+
+		#pragma omp for collapse(2) nowait
+		for (int k = 0; k < nz/2; k++)
+			for (int j = 0; j < ny/2; j++)
+				for (int i = 0; i < 1+nm/2; i++)
+					conc[k][j][i] = 1.0; /* left value */
+
+		#pragma omp for collapse(2)
+		for (int k = nz/2; k < nz; k++)
+			for (int j = ny/2; j < ny; j++)
+				for (int i = nx-1-nm/2; i < nx; i++)
+					conc[k][j][i] = 1.0; /* right value */
+
+		/* apply no-flux boundary conditions: inside to out, sequence matters */
+
+		for (int offset = 0; offset < nm/2; offset++) {
+			const int ilo = nm/2 - offset;
+			const int ihi = nx - 1 - nm/2 + offset;
+			#pragma omp for collapse(2)
+			for (int k = 0; k < nz; k++) {
+				for (int j = 0; j < ny; j++) {
+					conc[k][j][ilo-1] = conc[k][j][ilo]; /* left condition */
+					conc[k][j][ihi+1] = conc[k][j][ihi]; /* right condition */
+				}
+			}
+		}
+
+		for (int offset = 0; offset < nm/2; offset++) {
+			const int jlo = nm/2 - offset;
+			const int jhi = ny - 1 - nm/2 + offset;
+			#pragma omp for
+			for (int k = 0; k < nz; k++) {
+				for (int i = 0; i < nx; i++) {
+					conc[k][jlo-1][i] = conc[k][jlo][i]; /* bottom condition */
+					conc[k][jhi+1][i] = conc[k][jhi][i]; /* top condition */
+				}
+			}
+		}
+
+		for (int offset = 0; offset < nm/2; offset++) {
+			const int klo = nm/2 - offset;
+			const int khi = nz - 1 - nm/2 + offset;
+			#pragma omp for
+			for (int j = 0; j < ny; j++) {
+				for (int i = 0; i < nx; i++) {
+					conc[klo-1][j][i] = conc[klo][j][i]; /* back condition */
+					conc[khi+1][j][i] = conc[khi][j][i]; /* front condition */
+				}
+			}
+		}
+	}
+}
+
+void compute_convolution_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                            const int nx, const int ny, const int nz, const int nm)
+{
+	#pragma omp parallel for collapse(2)
+	for (int k = nm/2; k < nz-nm/2; k++) {
+		for (int j = nm/2; j < ny-nm/2; j++) {
+			for (int i = nm/2; i < nx-nm/2; i++) {
+				fp_t value = 0.0;
+				for (int mk = -nm/2; mk < nm/2+1; mk++) {
+					for (int mj = -nm/2; mj < nm/2+1; mj++) {
+						for (int mi = -nm/2; mi < nm/2+1; mi++) {
+							value += mask_lap[mk+nm/2][mj+nm/2][mi+nm/2] * conc_old[k+mk][j+mj][i+mi];
+						}
+					}
+				}
+				conc_lap[k][j][i] = value;
+			}
+		}
+	}
+}
+
+void compute_convolution_3d_blocked(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                                    const int nx, const int ny, const int nz, const int nm,
+                                    const int bx, const int by)
+{
+	const int ntx = (nx - 2 * (nm/2) + bx - 1) / bx;
+	const int nty = (ny - 2 * (nm/2) + by - 1) / by;
+
+	#pragma omp parallel
+	{
+		/* each thread streams its columns through a private plane queue */
+		fp_t* queue = (fp_t*)malloc(column_buffer_size(bx, by, nm) * sizeof(fp_t));
+
+		#pragma omp for schedule(dynamic)
+		for (int t = 0; t < ntx * nty; t++) {
+			const int x0 = nm/2 + bx * (t % ntx);
+			const int y0 = nm/2 + by * (t / ntx);
+			const int x1 = (x0 + bx < nx-nm/2) ? x0 + bx : nx-nm/2;
+			const int y1 = (y0 + by < ny-nm/2) ? y0 + by : ny-nm/2;
+			convolve_column(conc_old, conc_lap, mask_lap, nz, nm, x0, x1, y0, y1, queue);
+		}
+
+		free(queue);
+	}
+}
+
+void update_composition_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** conc_new,
+                           const int nx, const int ny, const int nz, const int nm,
+                           const fp_t D, const fp_t dt)
+{
+	#pragma omp parallel for collapse(2)
+	for (int k = nm/2; k < nz-nm/2; k++) {
+		for (int j = nm/2; j < ny-nm/2; j++) {
+			for (int i = nm/2; i < nx-nm/2; i++) {
+				conc_new[k][j][i] = conc_old[k][j][i] + dt * D * conc_lap[k][j][i];
+			}
+		}
+	}
+}
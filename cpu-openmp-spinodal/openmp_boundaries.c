@@ -39,24 +39,25 @@ void apply_boundary_conditions(fp_t** conc, const int nx, const int ny, const in
 {
 	#pragma omp parallel
 	{
-		/* apply no-flux boundary conditions: inside to out, sequence matters */
+		/* apply no-flux boundary conditions by reflection across the wall, so
+		   that wider stencils, such as the biharmonic, see mirrored data */
 		for (int offset = 0; offset < nm/2; offset++) {
-			const int ilo = nm/2 - offset;
-			const int ihi = nx - 1 - nm/2 + offset;
+			const int ilo = nm/2 - 1 - offset;
+			const int ihi = nx - nm/2 + offset;
 			#pragma omp for
 			for (int j = 0; j < ny; j++) {
-				conc[j][ilo-1] = conc[j][ilo]; /* left condition */
-				conc[j][ihi+1] = conc[j][ihi]; /* right condition */
+				conc[j][ilo] = conc[j][nm/2 + offset]; /* left condition */
+				conc[j][ihi] = conc[j][nx - 1 - nm/2 - offset]; /* right condition */
 			}
 		}
 
 		for (int offset = 0; offset < nm/2; offset++) {
-			const int jlo = nm/2 - offset;
-			const int jhi = ny - 1 - nm/2 + offset;
+			const int jlo = nm/2 - 1 - offset;
+			const int jhi = ny - nm/2 + offset;
 			#pragma omp for
 			for (int i = 0; i < nx; i++) {
-				conc[jlo-1][i] = conc[jlo][i]; /* bottom condition */
-				conc[jhi+1][i] = conc[jhi][i]; /* top condition */
+				conc[jlo][i] = conc[nm/2 + offset][i]; /* bottom condition */
+				conc[jhi][i] = conc[ny - 1 - nm/2 - offset][i]; /* top condition */
 			}
 		}
 	}
@@ -9,26 +9,15 @@
 */
 
 #include <math.h>
+#include <stdlib.h>
 #include <omp.h>
 #include "boundaries.h"
 #include "mesh.h"
 #include "numerics.h"
 #include "timer.h"
 
-fp_t dfdc(const fp_t C)
-{
-	const fp_t Ca  = 0.3;
-	const fp_t Cb  = 0.7;
-	const fp_t rho = 5.0;
-
-	const fp_t A = C - Ca;
-	const fp_t B = Cb - C;
-
-	return 2.0 * rho * A * B * (Ca + Cb - 2.0 * C);
-}
-
 void compute_laplacian(fp_t** conc_old, fp_t** conc_lap,
-					   fp_t** mask_lap, const fp_t kappa,
+					   fp_t** mask_lap, const struct FreeEnergy* fe, const fp_t kappa,
 					   const int nx, const int ny, const int nm)
 {
 	#pragma omp parallel for collapse(2)
@@ -40,7 +29,7 @@ void compute_laplacian(fp_t** conc_old, fp_t** conc_lap,
 					value += mask_lap[mj+nm/2][mi+nm/2] * conc_old[j+mj][i+mi];
 				}
 			}
-			conc_lap[j][i] = dfdc(conc_old[j][i]) - kappa * value;
+			conc_lap[j][i] = energy_derivative(fe, conc_old[j][i]) - kappa * value;
 		}
 	}
 }
@@ -73,3 +62,159 @@ void update_composition(fp_t** conc_old, fp_t** conc_div, fp_t** conc_new,
 		}
 	}
 }
+
+void compute_chemical(fp_t** conc, fp_t** conc_chem, const struct FreeEnergy* fe,
+                      const int nx, const int ny)
+{
+	#pragma omp parallel for
+	for (int j = 0; j < ny; j++) {
+		energy_derivative_row(fe, conc[j], conc_chem[j], nx);
+	}
+}
+
+void compute_split_rate(fp_t** conc, fp_t** conc_chem, fp_t** conc_div,
+                        fp_t** mask_chem, fp_t** mask_bih, const fp_t kappa,
+                        const int nx, const int ny, const int nm)
+{
+	/* five-point Laplacian weights */
+	const fp_t lx = mask_chem[1][0];
+	const fp_t ly = mask_chem[0][1];
+	const fp_t lc = mask_chem[1][1];
+
+	/* thirteen-point biharmonic weights, scaled by kappa */
+	const fp_t bx1 = kappa * mask_bih[2][1];
+	const fp_t bx2 = kappa * mask_bih[2][0];
+	const fp_t by1 = kappa * mask_bih[1][2];
+	const fp_t by2 = kappa * mask_bih[0][2];
+	const fp_t bxy = kappa * mask_bih[1][1];
+	const fp_t bc  = kappa * mask_bih[2][2];
+
+	#pragma omp parallel for
+	for (int j = nm/2; j < ny-nm/2; j++) {
+		const fp_t* c   = conc[j];
+		const fp_t* cn  = conc[j-1];
+		const fp_t* cnn = conc[j-2];
+		const fp_t* cs  = conc[j+1];
+		const fp_t* css = conc[j+2];
+		const fp_t* f   = conc_chem[j];
+		const fp_t* fn  = conc_chem[j-1];
+		const fp_t* fs  = conc_chem[j+1];
+		fp_t* out = conc_div[j];
+
+		#pragma omp simd
+		for (int i = nm/2; i < nx-nm/2; i++) {
+			const fp_t lap = lc * f[i] + lx * (f[i-1] + f[i+1]) + ly * (fn[i] + fs[i]);
+			const fp_t bih = bc * c[i]
+			               + bx1 * (c[i-1] + c[i+1]) + bx2 * (c[i-2] + c[i+2])
+			               + by1 * (cn[i] + cs[i]) + by2 * (cnn[i] + css[i])
+			               + bxy * (cn[i-1] + cn[i+1] + cs[i-1] + cs[i+1]);
+			out[i] = lap - bih;
+		}
+	}
+}
+
+/**
+ \brief Compute one row of the chemical potential, \a j, into \a mu
+
+ The stencil is applied one mask entry at a time along the whole row, adding
+ terms to each point in the same order as compute_laplacian(), so the row
+ vectorizes without changing the result. Ghost values reflect interior
+ values, as apply_boundary_conditions() would leave them.
+*/
+static void chemical_potential_row(fp_t** conc, fp_t* mu, fp_t** mask_lap,
+                                   const struct FreeEnergy* fe, const fp_t kappa,
+                                   const int nx, const int nm, const int j)
+{
+	for (int i = nm/2; i < nx-nm/2; i++)
+		mu[i] = 0.0;
+
+	for (int mj = -nm/2; mj < nm/2+1; mj++) {
+		for (int mi = -nm/2; mi < nm/2+1; mi++) {
+			const fp_t weight = mask_lap[mj+nm/2][mi+nm/2];
+			const fp_t* row = &conc[j+mj][mi];
+			if (weight == 0.0)
+				continue;
+			for (int i = nm/2; i < nx-nm/2; i++)
+				mu[i] += weight * row[i];
+		}
+	}
+
+	#pragma omp simd
+	for (int i = nm/2; i < nx-nm/2; i++)
+		mu[i] = energy_derivative(fe, conc[j][i]) - kappa * mu[i];
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		mu[nm/2 - 1 - offset] = mu[nm/2 + offset];
+		mu[nx - nm/2 + offset] = mu[nx - 1 - nm/2 - offset];
+	}
+}
+
+void update_composition_fused(fp_t** conc_old, fp_t** conc_new, fp_t** mask_lap,
+                              const struct FreeEnergy* fe, const fp_t kappa,
+                              const int nx, const int ny, const int nm,
+                              const fp_t M, const fp_t dt)
+{
+	#pragma omp parallel
+	{
+		/* one band of rows per thread, so only 2(nm/2) rows of chemical
+		   potential per thread are computed twice */
+		const int nt = omp_get_num_threads();
+		const int t = omp_get_thread_num();
+		const int j0 = nm/2 + ((ny - 2*(nm/2)) * t) / nt;
+		const int j1 = nm/2 + ((ny - 2*(nm/2)) * (t+1)) / nt;
+
+		/* ring of nm rows: chemical potential of row jj lives in slot jj % nm */
+		fp_t* mu = (fp_t*)malloc(nm * nx * sizeof(fp_t));
+
+		for (int jj = j0 - nm/2; jj < j1 + nm/2; jj++) {
+			/* ghost rows reflect interior rows */
+			const int r = (jj < nm/2) ? 2*(nm/2) - 1 - jj : (jj > ny-1-nm/2) ? 2*(ny-nm/2) - 1 - jj : jj;
+			chemical_potential_row(conc_old, &mu[(jj % nm) * nx], mask_lap, fe, kappa, nx, nm, r);
+
+			/* the divergence lags nm/2 rows behind the chemical potential */
+			const int j = jj - nm/2;
+			if (j < j0)
+				continue;
+
+			/* accumulate the divergence in place, as for the chemical potential */
+			fp_t* out = conc_new[j];
+			for (int i = nm/2; i < nx-nm/2; i++)
+				out[i] = 0.0;
+
+			for (int mj = -nm/2; mj < nm/2+1; mj++) {
+				for (int mi = -nm/2; mi < nm/2+1; mi++) {
+					const fp_t weight = mask_lap[mj+nm/2][mi+nm/2];
+					const fp_t* row = &mu[((j+mj) % nm) * nx + mi];
+					if (weight == 0.0)
+						continue;
+					for (int i = nm/2; i < nx-nm/2; i++)
+						out[i] += weight * row[i];
+				}
+			}
+
+			for (int i = nm/2; i < nx-nm/2; i++)
+				out[i] = conc_old[j][i] + dt * M * out[i];
+		}
+
+		free(mu);
+	}
+}
+
+fp_t update_heun(fp_t** conc_old, fp_t** rate_old, fp_t** rate_mid, fp_t** conc_new,
+                 const int nx, const int ny, const int nm,
+                 const fp_t M, const fp_t dt)
+{
+	fp_t err = 0.;
+
+	#pragma omp parallel for collapse(2) reduction(max:err)
+	for (int j = nm/2; j < ny - nm/2; j++) {
+		for (int i = nm/2; i < nx - nm/2; i++) {
+			const fp_t diff = fabs(0.5 * dt * M * (rate_mid[j][i] - rate_old[j][i]));
+			conc_new[j][i] = conc_old[j][i] + 0.5 * dt * M * (rate_old[j][i] + rate_mid[j][i]);
+			if (diff > err)
+				err = diff;
+		}
+	}
+
+	return err;
+}
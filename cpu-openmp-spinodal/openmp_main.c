@@ -13,47 +13,129 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "adaptive.h"
 #include "boundaries.h"
 #include "mesh.h"
 #include "numerics.h"
 #include "output.h"
 #include "timer.h"
 
+/**
+ \brief Evaluate \f$\nabla^2(f'(c) - \kappa\nabla^2 c)\f$ into \a conc_div
+
+ \a conc_lap receives the chemical potential, with boundary conditions applied.
+ Given \a mask_chem, \a mask_lap is instead the biharmonic, and the split
+ operator of compute_split_rate() is used, \a conc_lap receiving \f$ f'(c)\f$.
+*/
+static void compute_rate(fp_t** conc, fp_t** conc_lap, fp_t** conc_div, fp_t** mask_lap,
+                         fp_t** mask_chem, const struct FreeEnergy* fe, const fp_t kappa,
+                         const int nx, const int ny, const int nm, struct Stopwatch* watch)
+{
+	timer_push("boundaries");
+	apply_boundary_conditions(conc, nx, ny, nm);
+	timer_pop();
+
+	if (mask_chem != NULL) {
+		timer_push("chemical");
+		compute_chemical(conc, conc_lap, fe, nx, ny);
+		watch->conv += timer_pop();
+
+		timer_push("split");
+		compute_split_rate(conc, conc_lap, conc_div, mask_chem, mask_lap, kappa, nx, ny, nm);
+		watch->conv += timer_pop();
+		return;
+	}
+
+	timer_push("laplacian");
+	compute_laplacian(conc, conc_lap, mask_lap, fe, kappa, nx, ny, nm);
+	watch->conv += timer_pop();
+
+	timer_push("boundaries");
+	apply_boundary_conditions(conc_lap, nx, ny, nm);
+	timer_pop();
+
+	timer_push("divergence");
+	compute_divergence(conc_lap, conc_div, mask_lap, nx, ny, nm);
+	watch->conv += timer_pop();
+}
+
 /**
  \brief Run simulation using input parameters specified on the command line
+
+ By default every step uses \f$\Delta t = co/(24 M\kappa)\f$ and forward
+ Euler. Given a positive tolerance \a tl in the parameter file, steps are
+ instead taken with the embedded Heun-Euler pair, starting from the same
+ \a dt and adapting it as described for struct Controller. Either way,
+ runlog.csv records the current \a dt and the number of rejected steps at
+ each checkpoint, following the usual columns. Fixed steps are taken by
+ update_composition_fused() unless \a fu is 0, in which case the chemical
+ potential, its divergence, and the update are separate sweeps; either way,
+ \a conv_time holds the stencil sweeps and \a step_time the rest. Mask
+ code 135 (size 5) takes the biharmonic directly, see compute_split_rate(),
+ rather than composing two Laplacians; the fused sweep is not used then.
 */
 int main(int argc, char* argv[])
 {
 	FILE * output;
 
 	/* declare default mesh size and resolution */
-	fp_t **conc_old, **conc_new, **conc_lap, **conc_div, **mask_lap;
+	fp_t **conc_old, **conc_new, **conc_lap, **conc_div, **conc_mid=NULL, **mask_lap, **mask_chem=NULL;
 	int bx=32, by=32, nx=202, ny=202, nm=3, code=53;
 	const fp_t dx=1.0, dy=1.0;
 
 	/* declare default materials and numerical parameters */
-	fp_t M=5.0, kappa=2.0, linStab=0.25, elapsed=0., energy=0.;
-	int step=0, steps=5000000, checks=100000;
+	fp_t M=5.0, kappa=2.0, linStab=0.25, elapsed=0., energy=0., tol=0.;
+	fp_t Ca=0.3, Cb=0.7, rho=5.0;
+	struct FreeEnergy fe;
+	int step=0, steps=5000000, checks=100000, fused=1;
 	struct Stopwatch watch = {0., 0., 0., 0.};
+	struct Controller ctl;
 
 	StartTimer();
 
 	param_parser(argc, argv, &bx, &by, &checks, &code, &M, &kappa, &linStab, &nm, &nx, &ny, &steps);
+	param_optional_fp(argc, argv, "tl", &tol);
+	param_optional_int(argc, argv, "fu", &fused);
+	param_optional_fp(argc, argv, "ca", &Ca);
+	param_optional_fp(argc, argv, "cb", &Cb);
+	param_optional_fp(argc, argv, "rh", &rho);
+	double_well_energy(&fe, Ca, Cb, rho);
 
-	const fp_t dt = linStab / (24.0 * M * kappa);
+	fp_t dt = linStab / (24.0 * M * kappa);
 
 	/* initialize memory */
 	make_arrays(&conc_old, &conc_new, &conc_lap, &conc_div, &mask_lap, nx, ny, nm);
 	set_mask(dx, dy, code, mask_lap, nm);
 
+	if (code == 135) {
+		/* split operator: mask_lap is the biharmonic, mask_chem the Laplacian of f'(c) */
+		mask_chem = (fp_t**)calloc(3, sizeof(fp_t*));
+		mask_chem[0] = (fp_t*)calloc(3 * 3, sizeof(fp_t));
+		for (int j = 1; j < 3; j++)
+			mask_chem[j] = &(mask_chem[0][3 * j]);
+		five_point_Laplacian_stencil(dx, dy, mask_chem, 3);
+	}
+
 	print_progress(step, steps);
 
-	double start_time = GetTimer();
+	timer_push("initial conditions");
 	apply_initial_conditions(conc_old, nx, ny, nm);
-	watch.step = GetTimer() - start_time;
+	watch.step = timer_pop();
+
+	if (tol > 0.) {
+		/* the Heun corrector needs the rate at the Euler predictor, too */
+		conc_mid = (fp_t**)calloc(ny, sizeof(fp_t*));
+		conc_mid[0] = (fp_t*)calloc(nx * ny, sizeof(fp_t));
+		for (int j = 1; j < ny; j++)
+			conc_mid[j] = &(conc_mid[0][nx * j]);
+
+		apply_boundary_conditions(conc_old, nx, ny, nm);
+		free_energy(conc_old, dx, dy, nx, ny, nm, &fe, kappa, &energy);
+		init_controller(&ctl, tol, dt, energy);
+	}
 
 	/* write initial condition data */
-	start_time = GetTimer();
+	timer_push("write_png");
 	write_png(conc_old, nx, ny, 0);
 
 	/* prepare to log comparison to analytical solution */
@@ -62,11 +144,11 @@ int main(int argc, char* argv[])
 		printf("Error: unable to %s for output. Check permissions.\n", "runlog.csv");
 		exit(-1);
 	}
-	watch.file = GetTimer() - start_time;
+	watch.file = timer_pop();
 
-	fprintf(output, "iter,sim_time,energy,conv_time,step_time,IO_time,run_time\n");
-	fprintf(output, "%i,%f,%f,%f,%f,%f,%f\n", step, elapsed, nx*dx * ny*dy * chem_energy(0.5),
-			watch.conv, watch.step, watch.file, GetTimer());
+	fprintf(output, "iter,sim_time,energy,conv_time,step_time,IO_time,run_time,dt,rejected\n");
+	fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%g,%i\n", step, elapsed, nx*dx * ny*dy * energy_density(&fe, 0.5),
+			watch.conv, watch.step, watch.file, GetTimer(), dt, 0);
 	fflush(output);
 
 	/* do the work */
@@ -74,44 +156,86 @@ int main(int argc, char* argv[])
 		print_progress(step, steps);
 
 		/* === Start Architecture-Specific Kernel === */
-		apply_boundary_conditions(conc_old, nx, ny, nm);
-
-		start_time = GetTimer();
-		compute_laplacian(conc_old, conc_lap, mask_lap, kappa, nx, ny, nm);
-		watch.conv += GetTimer() - start_time;
-
-		apply_boundary_conditions(conc_lap, nx, ny, nm);
-
-		start_time = GetTimer();
-		compute_divergence(conc_lap, conc_div, mask_lap, nx, ny, nm);
-		watch.conv += GetTimer() - start_time;
-
-		start_time = GetTimer();
-		update_composition(conc_old, conc_div, conc_new, nx, ny, nm, M, dt);
-		watch.step += GetTimer() - start_time;
+		timer_push("timestep");
+		if (tol > 0.) {
+			fp_t err;
+
+			/* the rate at the current state serves every trial of this step */
+			compute_rate(conc_old, conc_lap, conc_div, mask_lap, mask_chem, &fe, kappa, nx, ny, nm, &watch);
+
+			do {
+				dt = ctl.dt;
+
+				timer_push("update");
+				update_composition(conc_old, conc_div, conc_new, nx, ny, nm, M, dt);
+				watch.step += timer_pop();
+
+				compute_rate(conc_new, conc_lap, conc_mid, mask_lap, mask_chem, &fe, kappa, nx, ny, nm, &watch);
+
+				timer_push("update");
+				err = update_heun(conc_old, conc_div, conc_mid, conc_new, nx, ny, nm, M, dt);
+				watch.step += timer_pop();
+
+				timer_push("free_energy");
+				apply_boundary_conditions(conc_new, nx, ny, nm);
+				free_energy(conc_new, dx, dy, nx, ny, nm, &fe, kappa, &energy);
+				watch.step += timer_pop();
+			} while (!accept_step(&ctl, err, energy));
+		} else if (fused && mask_chem == NULL) {
+			timer_push("boundaries");
+			apply_boundary_conditions(conc_old, nx, ny, nm);
+			timer_pop();
+
+			timer_push("fused");
+			update_composition_fused(conc_old, conc_new, mask_lap, &fe, kappa, nx, ny, nm, M, dt);
+			watch.conv += timer_pop();
+		} else {
+			compute_rate(conc_old, conc_lap, conc_div, mask_lap, mask_chem, &fe, kappa, nx, ny, nm, &watch);
+
+			timer_push("update");
+			update_composition(conc_old, conc_div, conc_new, nx, ny, nm, M, dt);
+			watch.step += timer_pop();
+		}
 
 		swap_pointers(&conc_old, &conc_new);
 		elapsed += dt;
+		timer_pop();
 		/* === Finish Architecture-Specific Kernel === */
 
 		if (step % checks == 0) {
-			start_time = GetTimer();
-			write_png(conc_old, nx, ny, dt*step);
-			watch.file += GetTimer() - start_time;
-
-			free_energy(conc_old, conc_lap, dx, dy, nx, ny, nm, kappa, &energy);
-
-			fprintf(output, "%i,%f,%f,%f,%f,%f,%f\n", step, elapsed, energy,
-					watch.conv, watch.step, watch.file, GetTimer());
+			timer_push("write_png");
+			write_png(conc_old, nx, ny, elapsed);
+			watch.file += timer_pop();
+
+			if (tol > 0.) {
+				/* already evaluated to accept the step */
+				energy = ctl.energy;
+			} else {
+				timer_push("free_energy");
+				free_energy(conc_old, dx, dy, nx, ny, nm, &fe, kappa, &energy);
+				timer_pop();
+			}
+
+			fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%g,%i\n", step, elapsed, energy,
+					watch.conv, watch.step, watch.file, GetTimer(), dt, (tol > 0.) ? ctl.rejected : 0);
 			fflush(output);
 		}
 	}
 
-	write_csv(conc_old, nx, ny, dx, dy, dt*steps);
+	write_csv(conc_old, nx, ny, dx, dy, elapsed);
+	timer_report(stdout);
 
 	/* clean up */
 	fclose(output);
 	free_arrays(conc_old, conc_new, conc_lap, conc_div, mask_lap);
+	if (conc_mid != NULL) {
+		free(conc_mid[0]);
+		free(conc_mid);
+	}
+	if (mask_chem != NULL) {
+		free(mask_chem[0]);
+		free(mask_chem);
+	}
 
 	return 0;
 }
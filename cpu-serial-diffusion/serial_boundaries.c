@@ -10,6 +10,7 @@
 
 #include <math.h>
 #include "boundaries.h"
+#include "tiles.h"
 
 void apply_initial_conditions(fp_t** conc, const int nx, const int ny, const int nm)
 {
@@ -62,3 +63,68 @@ void apply_boundary_conditions(fp_t** conc, const int nx, const int ny, const in
 		}
 	}
 }
+
+void apply_initial_conditions_tiled(struct Tiles* conc, const int nm)
+{
+	const int nx = conc->nx;
+	const int ny = conc->ny;
+
+	for (int j = 0; j < ny; j++)
+		for (int i = 0; i < nx; i++)
+			*tiled_value(conc, i, j) = 0.0;
+
+	for (int j = 0; j < ny/2; j++)
+		for (int i = 0; i < 1+nm/2; i++)
+			*tiled_value(conc, i, j) = 1.0; /* left half-wall */
+
+	for (int j = ny/2; j < ny; j++)
+		for (int i = nx-1-nm/2; i < nx; i++)
+			*tiled_value(conc, i, j) = 1.0; /* right half-wall */
+}
+
+void apply_boundary_conditions_tiled(struct Tiles* conc, const int nm)
+{
+	const int nx = conc->nx;
+	const int ny = conc->ny;
+
+	/* apply fixed boundary values: sequence does not matter */
+
+	for (int j = 0; j < ny/2; j++) {
+		for (int i = 0; i < 1+nm/2; i++) {
+			*tiled_value(conc, i, j) = 1.0; /* left value */
+		}
+	}
+
+	for (int j = ny/2; j < ny; j++) {
+		for (int i = nx-1-nm/2; i < nx; i++) {
+			*tiled_value(conc, i, j) = 1.0; /* right value */
+		}
+	}
+
+	/* apply no-flux boundary conditions: inside to out, sequence matters */
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		for (int j = 0; j < ny; j++) {
+			*tiled_value(conc, ilo-1, j) = *tiled_value(conc, ilo, j); /* left condition */
+			*tiled_value(conc, ihi+1, j) = *tiled_value(conc, ihi, j); /* right condition */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		for (int i = 0; i < nx; i++) {
+			*tiled_value(conc, i, jlo-1) = *tiled_value(conc, i, jlo); /* bottom condition */
+			*tiled_value(conc, i, jhi+1) = *tiled_value(conc, i, jhi); /* top condition */
+		}
+	}
+
+	/* refresh halos the next sweep reads from the updated tile interiors */
+
+	for (int k = 0; k < sweep_count(conc); k++) {
+		const int tile = sweep_tile(conc, k);
+		refresh_tile_halo(conc, tile % conc->ntx, tile / conc->ntx);
+	}
+}
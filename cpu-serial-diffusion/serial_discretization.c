@@ -10,13 +10,18 @@
 
 #include <math.h>
 #include "boundaries.h"
+#include "integrator.h"
 #include "mesh.h"
 #include "numerics.h"
+#include "tiles.h"
 #include "timer.h"
+#include "trace.h"
 
 void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
                          const int nx, const int ny, const int nm)
 {
+	const unsigned long long start = trace_begin();
+
 	for (int j = nm/2; j < ny-nm/2; j++) {
 		for (int i = nm/2; i < nx-nm/2; i++) {
 			fp_t value = 0.0;
@@ -28,15 +33,63 @@ void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
 			conc_lap[j][i] = value;
 		}
 	}
+
+	trace_end("convolution", -1, start);
 }
 
 void update_composition(fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
 						const int nx, const int ny, const int nm,
 						const fp_t D, const fp_t dt)
 {
+	const unsigned long long start = trace_begin();
+
 	for (int j = nm/2; j < ny-nm/2; j++) {
 		for (int i = nm/2; i < nx-nm/2; i++) {
 			conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
 		}
 	}
+
+	trace_end("update", -1, start);
+}
+
+void combine_stages(fp_t** out,
+                    const fp_t c0, fp_t** y0, const fp_t c1, fp_t** y1, const fp_t c2, fp_t** y2,
+                    const fp_t c3, fp_t** l0, const fp_t c4, fp_t** l1,
+                    const int nx, const int ny, const int nm)
+{
+	const unsigned long long start = trace_begin();
+
+	/* loop-invariant NULL tests are hoisted out by the compiler */
+	for (int j = nm/2; j < ny-nm/2; j++) {
+		for (int i = nm/2; i < nx-nm/2; i++) {
+			fp_t value = 0.0;
+			if (y0 != NULL) value += c0 * y0[j][i];
+			if (y1 != NULL) value += c1 * y1[j][i];
+			if (y2 != NULL) value += c2 * y2[j][i];
+			if (l0 != NULL) value += c3 * l0[j][i];
+			if (l1 != NULL) value += c4 * l1[j][i];
+			out[j][i] = value;
+		}
+	}
+
+	trace_end("update", -1, start);
+}
+
+void compute_convolution_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                               fp_t** mask_lap, const int nm)
+{
+	for (int k = 0; k < sweep_count(conc_old); k++) {
+		const int tile = sweep_tile(conc_old, k);
+		convolve_tile(conc_old, conc_lap, mask_lap, nm, tile % conc_old->ntx, tile / conc_old->ntx);
+	}
+}
+
+void update_composition_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                              struct Tiles* conc_new, const int nm,
+                              const fp_t D, const fp_t dt)
+{
+	for (int k = 0; k < sweep_count(conc_old); k++) {
+		const int tile = sweep_tile(conc_old, k);
+		update_tile(conc_old, conc_lap, conc_new, nm, tile % conc_old->ntx, tile / conc_old->ntx, D, dt);
+	}
 }
@@ -14,10 +14,16 @@
 #include <string.h>
 
 #include "boundaries.h"
+#include "counters.h"
+#include "integrator.h"
 #include "mesh.h"
 #include "numerics.h"
 #include "output.h"
+#include "roofline.h"
+#include "sampling.h"
+#include "tiles.h"
 #include "timer.h"
+#include "trace.h"
 
 /**
  \brief Run simulation using input parameters specified on the command line
@@ -28,7 +34,19 @@
  energy (\a energy), error relative to analytical solution (\a wrss), time spent
  performing convolution (\a conv_time), time spent updating fields (\a step_time),
  time spent writing to disk (\a IO_time), time spent generating analytical values
- (\a soln_time), and total elapsed (\a run_time).
+ (\a soln_time), total elapsed (\a run_time), the sampling columns described by
+ print_sampling(), the roofline columns described by print_roofline(), and
+ the hardware event counts described by print_counters().
+ Setting \a tr in the parameter file also writes trace.json, a per-thread
+ timeline of kernels, tiles, boundary conditions, and I/O. Setting \a ts
+ times only a sample of steps, see struct Sampler. Setting \a ti selects a
+ multi-stage time integrator, see struct Integrator; its longer steps are
+ whole multiples of the forward-Euler \a dt, so checkpoints, and hence
+ \a wrss, fall at the same \a sim_time for every scheme and \a run_time
+ compares their time to solution directly. Setting \a at in tiled builds
+ skips tiles at steady state, see struct Activity; the mean fraction of
+ tiles swept per step since the previous checkpoint is logged as
+ \a active, always 1 when every tile is swept.
 */
 int main(int argc, char* argv[])
 {
@@ -36,88 +54,269 @@ int main(int argc, char* argv[])
 
 	/* declare default mesh size and resolution */
 	fp_t **conc_old, **conc_new, **conc_lap, **mask_lap;
+	#ifdef TILED
+	struct Tiles tile_old, tile_new, tile_lap;
+	struct Activity act;
+	fp_t steady=-1.;
+	#endif
 	int bx=32, by=32, nx=512, ny=512, nm=3, code=53;
 	fp_t dx=0.5, dy=0.5, h;
 
 	/* declare default materials and numerical parameters */
 	fp_t D=0.00625, linStab=0.1, dt=1., elapsed=0., rss=0.;
 	int step=0, steps=100000, checks=10000;
-	double start_time=0.;
 	struct Stopwatch watch = {0., 0., 0., 0.};
+	struct Roofline roof;
+	int stream=0, counters=0, events=0, interval=1, randomized=0;
+	struct Sampler sampler;
+	struct Integrator integ;
+	int scheme=INTEGRATOR_EULER, stages=10, multiple=1;
+	unsigned long long trace_start;
+	long long start_events[NUM_EVENTS];
 
 	StartTimer();
 
 	param_parser(argc, argv, &bx, &by, &checks, &code, &D, &dx, &dy, &linStab, &nm, &nx, &ny, &steps);
+	param_optional_int(argc, argv, "pc", &counters);
+	open_counters(counters);
+	param_optional_int(argc, argv, "tr", &events);
+	open_trace(events);
+	param_optional_int(argc, argv, "ts", &interval);
+	param_optional_int(argc, argv, "rs", &randomized);
+	init_sampler(&sampler, interval, randomized);
 
 	h = (dx > dy) ? dy : dx;
 	dt = (linStab * h * h) / (4.0 * D);
 
+	/* multi-stage integrators take a whole number of Euler-sized steps at once */
+	param_optional_int(argc, argv, "ti", &scheme);
+	param_optional_int(argc, argv, "is", &stages);
+	init_integrator(&integ, scheme, stages, nx, ny);
+	#ifdef TILED
+	if (integ.scheme != INTEGRATOR_EULER) {
+		printf("Error: the %s integrator is not implemented for tiled fields.\n", integrator_name(&integ));
+		exit(-1);
+	}
+	#endif
+	multiple = integrator_multiple(&integ, checks);
+	dt *= multiple;
+	steps /= multiple;
+	checks /= multiple;
+
 	/* initialize memory */
 	make_arrays(&conc_old, &conc_new, &conc_lap, &mask_lap, nx, ny, nm);
 	set_mask(dx, dy, code, mask_lap, nm);
+	roofline_model(mask_lap, nx, ny, nm, &roof);
+	param_optional_int(argc, argv, "st", &stream);
+	if (stream > 0)
+		roof.peak_bw = stream_triad(1000000 * stream);
+	#ifdef TILED
+	make_tiles(&tile_old, nx, ny, bx, by, nm);
+	make_tiles(&tile_new, nx, ny, bx, by, nm);
+	make_tiles(&tile_lap, nx, ny, bx, by, nm);
+	param_optional_fp(argc, argv, "at", &steady);
+	if (steady >= 0.) {
+		make_activity(&act, &tile_old, steady);
+		tile_old.activity = &act;
+	}
+	#endif
 
 	print_progress(0, steps);
 
-	start_time = GetTimer();
+	timer_push("initial conditions");
+	#ifdef TILED
+	apply_initial_conditions_tiled(&tile_old, nm);
+	#else
 	apply_initial_conditions(conc_old, nx, ny, nm);
-	watch.step = GetTimer() - start_time;
+	#endif
+	timer_pop();
 
 	/* prepare to log comparison to analytical solution */
+	timer_push("runlog");
 	output = fopen("runlog.csv", "w");
 	if (output == NULL) {
 		printf("Error: unable to %s for output. Check permissions.\n", "runlog.csv");
 		exit(-1);
 	}
-	watch.file = GetTimer() - start_time;
+	watch.file += timer_pop();
 
-	fprintf(output, "iter,sim_time,wrss,conv_time,step_time,IO_time,soln_time,run_time\n");
-	fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f\n", step, elapsed, rss,
+	fprintf(output, "iter,sim_time,wrss,conv_time,step_time,IO_time,soln_time,run_time" SAMPLING_HEADER ROOFLINE_HEADER COUNTERS_HEADER ",active\n");
+	estimate_stopwatch(&sampler, &watch);
+	trace_start = trace_begin();
+	fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f", step, elapsed, rss,
 			watch.conv, watch.step, watch.file, watch.soln, GetTimer());
+	print_sampling(output, &sampler);
+	print_roofline(output, &roof, &watch, step * integ.stages);
+	print_counters(output, &watch);
+	#ifdef TILED
+	fprintf(output, ",%f", (tile_old.activity != NULL) ? activity_fraction(&act) : 1.);
+	#else
+	fprintf(output, ",%f", 1.);
+	#endif
+	fprintf(output, "\n");
 	fflush(output);
+	trace_end("runlog", -1, trace_start);
 
 	/* write initial condition data */
-	start_time = GetTimer();
+	timer_push("write_png");
+	#ifdef TILED
+	tiles_to_rowmajor(&tile_old, conc_old);
+	#endif
+	trace_start = trace_begin();
 	write_png(conc_old, nx, ny, 0);
+	trace_end("write_png", -1, trace_start);
+	watch.file += timer_pop();
 
 	/* do the work */
 	for (step = 1; step < steps+1; step++) {
 		print_progress(step, steps);
 
 		/* === Start Architecture-Specific Kernel === */
-		apply_boundary_conditions(conc_old, nx, ny, nm);
+		#ifdef TILED
+		if (tile_old.activity != NULL)
+			plan_activity(&act, &tile_old, &tile_new);
+		#endif
+
+		if (sample_step(&sampler)) {
+			timer_push("timestep");
+			#ifdef TILED
+			read_counters(start_events);
+			timer_push("boundaries");
+			trace_start = trace_begin();
+			apply_boundary_conditions_tiled(&tile_old, nm);
+			trace_end("boundaries", -1, trace_start);
+			timer_pop();
+			accumulate_counters(watch.events[PHASE_BC], start_events);
+
+			read_counters(start_events);
+			timer_push("convolution");
+			compute_convolution_tiled(&tile_old, &tile_lap, mask_lap, nm);
+			record_sample(&sampler, SAMPLE_CONV, timer_pop());
+			accumulate_counters(watch.events[PHASE_CONV], start_events);
+
+			read_counters(start_events);
+			timer_push("update");
+			update_composition_tiled(&tile_old, &tile_lap, &tile_new, nm, D, dt);
+			record_sample(&sampler, SAMPLE_STEP, timer_pop());
+			accumulate_counters(watch.events[PHASE_STEP], start_events);
+
+			swap_tiles(&tile_old, &tile_new);
+			elapsed += dt;
+			#else
+			if (integ.scheme == INTEGRATOR_EULER) {
+				read_counters(start_events);
+				timer_push("boundaries");
+				trace_start = trace_begin();
+				apply_boundary_conditions(conc_old, nx, ny, nm);
+				trace_end("boundaries", -1, trace_start);
+				timer_pop();
+				accumulate_counters(watch.events[PHASE_BC], start_events);
 
-		start_time = GetTimer();
-		compute_convolution(conc_old, conc_lap, mask_lap, nx, ny, nm);
-		watch.conv += GetTimer() - start_time;
+				read_counters(start_events);
+				timer_push("convolution");
+				compute_convolution(conc_old, conc_lap, mask_lap, nx, ny, nm);
+				record_sample(&sampler, SAMPLE_CONV, timer_pop());
+				accumulate_counters(watch.events[PHASE_CONV], start_events);
 
-		start_time = GetTimer();
-		update_composition(conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
-		watch.step += GetTimer() - start_time;
+				read_counters(start_events);
+				timer_push("update");
+				update_composition(conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
+				record_sample(&sampler, SAMPLE_STEP, timer_pop());
+				accumulate_counters(watch.events[PHASE_STEP], start_events);
+			} else {
+				/* counters are not split by phase across stages */
+				integrate_step(&integ, conc_old, conc_new, conc_lap, mask_lap, nx, ny, nm, D, dt, 1);
+				record_sample(&sampler, SAMPLE_CONV, integ.conv_time);
+				record_sample(&sampler, SAMPLE_STEP, integ.step_time);
+			}
 
-		swap_pointers(&conc_old, &conc_new);
-		elapsed += dt;
+			swap_pointers(&conc_old, &conc_new);
+			elapsed += dt;
+			#endif
+			timer_pop();
+		} else {
+			/* untimed fast path */
+			#ifdef TILED
+			apply_boundary_conditions_tiled(&tile_old, nm);
+			compute_convolution_tiled(&tile_old, &tile_lap, mask_lap, nm);
+			update_composition_tiled(&tile_old, &tile_lap, &tile_new, nm, D, dt);
+			swap_tiles(&tile_old, &tile_new);
+			#else
+			if (integ.scheme == INTEGRATOR_EULER) {
+				apply_boundary_conditions(conc_old, nx, ny, nm);
+				compute_convolution(conc_old, conc_lap, mask_lap, nx, ny, nm);
+				update_composition(conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
+			} else {
+				integrate_step(&integ, conc_old, conc_new, conc_lap, mask_lap, nx, ny, nm, D, dt, 0);
+			}
+			swap_pointers(&conc_old, &conc_new);
+			#endif
+			elapsed += dt;
+		}
 		/* === Finish Architecture-Specific Kernel === */
 
 		if (step % checks == 0) {
-			start_time = GetTimer();
+			timer_push("write_png");
+			#ifdef TILED
+			tiles_to_rowmajor(&tile_old, conc_old);
+			#endif
+			trace_start = trace_begin();
 			write_png(conc_old, nx, ny, step);
-			watch.file += GetTimer() - start_time;
+			trace_end("write_png", -1, trace_start);
+			watch.file += timer_pop();
 
-			start_time = GetTimer();
+			read_counters(start_events);
+			timer_push("check_solution");
+			trace_start = trace_begin();
 			check_solution(conc_old, conc_lap, nx, ny, dx, dy, nm, elapsed, D, &rss);
-			watch.soln += GetTimer() - start_time;
+			trace_end("check_solution", -1, trace_start);
+			watch.soln += timer_pop();
+			accumulate_counters(watch.events[PHASE_SOLN], start_events);
 
-			fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f\n", step, elapsed, rss,
+			estimate_stopwatch(&sampler, &watch);
+			trace_start = trace_begin();
+			fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f", step, elapsed, rss,
 					watch.conv, watch.step, watch.file, watch.soln, GetTimer());
+			print_sampling(output, &sampler);
+			print_roofline(output, &roof, &watch, step * integ.stages);
+			print_counters(output, &watch);
+			#ifdef TILED
+			fprintf(output, ",%f", (tile_old.activity != NULL) ? activity_fraction(&act) : 1.);
+			#else
+			fprintf(output, ",%f", 1.);
+			#endif
+			fprintf(output, "\n");
 			fflush(output);
+			trace_end("runlog", -1, trace_start);
 	   }
 	}
 
+	#ifdef TILED
+	tiles_to_rowmajor(&tile_old, conc_old);
+	#endif
+	trace_start = trace_begin();
 	write_csv(conc_old, nx, ny, dx, dy, steps);
+	trace_end("write_csv", -1, trace_start);
+	estimate_stopwatch(&sampler, &watch);
+	summarize_roofline(&roof, &watch, steps * integ.stages);
+	printf("%s integrator, %i stages, dt %g (%i x forward Euler): wrss %g at sim_time %g in %f s\n",
+	       integrator_name(&integ), integ.stages, dt, multiple, rss, elapsed, GetTimer());
+	timer_report(stdout);
 
 	/* clean up */
 	fclose(output);
+	close_counters();
+	write_trace("trace.json");
+	close_trace();
 	free_arrays(conc_old, conc_new, conc_lap, mask_lap);
+	free_integrator(&integ);
+	#ifdef TILED
+	free_tiles(&tile_old);
+	free_tiles(&tile_new);
+	free_tiles(&tile_lap);
+	if (tile_old.activity != NULL)
+		free_activity(&act);
+	#endif
 
 	return 0;
 }
@@ -0,0 +1,130 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  serial_volume.c
+ \brief Implementation of 3D boundary condition and discretization functions without threading
+*/
+
+#include <stdlib.h>
+#include "volume.h"
+
+void apply_initial_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm)
+{
+	for (int k = 0; k < nz; k++)
+		for (int j = 0; j < ny; j++)
+			for (int i = 0; i < nx; i++)
+				conc[k][j][i] = 0.0;
+
+	for (int k = 0; k < nz/2; k++)
+		for (int j = 0; j < ny/2; j++)
+			for (int i = 0; i < 1+nm/2; i++)
+				conc[k][j][i] = 1.0; /* left quarter-wall */
+
+	for (int k = nz/2; k < nz; k++)
+		for (int j = ny/2; j < ny; j++)
+			for (int i = nx-1-nm/2; i < nx; i++)
+				conc[k][j][i] = 1.0; /* right quarter-wall */
+}
+
+void apply_boundary_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm)
+{
+	/* apply fixed boundary values: sequence does not matter */
+
+	for (int k = 0; k < nz/2; k++)
+		for (int j = 0; j < ny/2; j++)
+			for (int i = 0; i < 1+nm/2; i++)
+				conc[k][j][i] = 1.0; /* left value */
+
+	for (int k = nz/2; k < nz; k++)
+		for (int j = ny/2; j < ny; j++)
+			for (int i = nx-1-nm/2; i < nx; i++)
+				conc[k][j][i] = 1.0; /* right value */
+
+	/* apply no-flux boundary conditions: inside to out, sequence matters */
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		for (int k = 0; k < nz; k++) {
+			for (int j = 0; j < ny; j++) {
+				conc[k][j][ilo-1] = conc[k][j][ilo]; /* left condition */
+				conc[k][j][ihi+1] = conc[k][j][ihi]; /* right condition */
+			}
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		for (int k = 0; k < nz; k++) {
+			for (int i = 0; i < nx; i++) {
+				conc[k][jlo-1][i] = conc[k][jlo][i]; /* bottom condition */
+				conc[k][jhi+1][i] = conc[k][jhi][i]; /* top condition */
+			}
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int klo = nm/2 - offset;
+		const int khi = nz - 1 - nm/2 + offset;
+		for (int j = 0; j < ny; j++) {
+			for (int i = 0; i < nx; i++) {
+				conc[klo-1][j][i] = conc[klo][j][i]; /* back condition */
+				conc[khi+1][j][i] = conc[khi][j][i]; /* front condition */
+			}
+		}
+	}
+}
+
+void compute_convolution_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                            const int nx, const int ny, const int nz, const int nm)
+{
+	for (int k = nm/2; k < nz-nm/2; k++) {
+		for (int j = nm/2; j < ny-nm/2; j++) {
+			for (int i = nm/2; i < nx-nm/2; i++) {
+				fp_t value = 0.0;
+				for (int mk = -nm/2; mk < nm/2+1; mk++) {
+					for (int mj = -nm/2; mj < nm/2+1; mj++) {
+						for (int mi = -nm/2; mi < nm/2+1; mi++) {
+							value += mask_lap[mk+nm/2][mj+nm/2][mi+nm/2] * conc_old[k+mk][j+mj][i+mi];
+						}
+					}
+				}
+				conc_lap[k][j][i] = value;
+			}
+		}
+	}
+}
+
+void compute_convolution_3d_blocked(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                                    const int nx, const int ny, const int nz, const int nm,
+                                    const int bx, const int by)
+{
+	fp_t* queue = (fp_t*)malloc(column_buffer_size(bx, by, nm) * sizeof(fp_t));
+
+	for (int y0 = nm/2; y0 < ny-nm/2; y0 += by) {
+		const int y1 = (y0 + by < ny-nm/2) ? y0 + by : ny-nm/2;
+		for (int x0 = nm/2; x0 < nx-nm/2; x0 += bx) {
+			const int x1 = (x0 + bx < nx-nm/2) ? x0 + bx : nx-nm/2;
+			convolve_column(conc_old, conc_lap, mask_lap, nz, nm, x0, x1, y0, y1, queue);
+		}
+	}
+
+	free(queue);
+}
+
+void update_composition_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** conc_new,
+                           const int nx, const int ny, const int nz, const int nm,
+                           const fp_t D, const fp_t dt)
+{
+	for (int k = nm/2; k < nz-nm/2; k++) {
+		for (int j = nm/2; j < ny-nm/2; j++) {
+			for (int i = nm/2; i < nx-nm/2; i++) {
+				conc_new[k][j][i] = conc_old[k][j][i] + dt * D * conc_lap[k][j][i];
+			}
+		}
+	}
+}
@@ -14,6 +14,7 @@
 #include <tbb/blocked_range.h>
 #include <tbb/blocked_range2d.h>
 #include "boundaries.h"
+#include "tiles.h"
 
 void apply_initial_conditions(fp_t** conc, const int nx, const int ny, const int nm)
 {
@@ -107,3 +108,112 @@ void apply_boundary_conditions(fp_t** conc, const int nx, const int ny, const in
 		);
 	}
 }
+
+void apply_initial_conditions_tiled(struct Tiles* conc, const int nm)
+{
+	const int nx = conc->nx;
+	const int ny = conc->ny;
+
+	/* Lambda function executed on each thread, applying flat field values */
+	tbb::parallel_for(tbb::blocked_range2d<int>(0, nx, 0, ny),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
+					*tiled_value(conc, i, j) = 0.;
+				}
+			}
+		}
+	);
+
+	/* Lambda function executed on each thread, applying left boundary values */
+	tbb::parallel_for(tbb::blocked_range2d<int>(0, 1+nm/2, 0, ny/2),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
+					*tiled_value(conc, i, j) = 1.;
+				}
+			}
+		}
+	);
+
+	/* Lambda function executed on each thread, applying right boundary values */
+	tbb::parallel_for(tbb::blocked_range2d<int>(nx-1-nm/2, nx, ny/2, ny),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
+					*tiled_value(conc, i, j) = 1.;
+				}
+			}
+		}
+	);
+}
+
+void apply_boundary_conditions_tiled(struct Tiles* conc, const int nm)
+{
+	const int nx = conc->nx;
+	const int ny = conc->ny;
+
+	/* apply fixed boundary values: sequence does not matter */
+
+	/* Lambda function executed on each thread, applying left boundary values */
+	tbb::parallel_for(tbb::blocked_range2d<int>(0, 1+nm/2, 0, ny/2),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
+					*tiled_value(conc, i, j) = 1.;
+				}
+			}
+		}
+	);
+
+	/* Lambda function executed on each thread, applying right boundary values */
+	tbb::parallel_for(tbb::blocked_range2d<int>(nx-1-nm/2, nx, ny/2, ny),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
+					*tiled_value(conc, i, j) = 1.;
+				}
+			}
+		}
+	);
+
+	/* apply no-flux boundary conditions: inside to out, sequence matters */
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		/* Lambda function executed on each thread, applying x-axis boundary condition */
+		tbb::parallel_for(tbb::blocked_range<int>(0, ny),
+			[=](const tbb::blocked_range<int>& r) {
+				for (int j = r.begin(); j != r.end(); j++) {
+					*tiled_value(conc, ilo-1, j) = *tiled_value(conc, ilo, j); /* left */
+					*tiled_value(conc, ihi+1, j) = *tiled_value(conc, ihi, j); /* right */
+				}
+			}
+		);
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		/* Lambda function executed on each thread, applying y-axis boundary condition */
+		tbb::parallel_for(tbb::blocked_range<int>(0, nx),
+			[=](const tbb::blocked_range<int>& r) {
+				for (int i = r.begin(); i != r.end(); i++) {
+					*tiled_value(conc, i, jlo-1) = *tiled_value(conc, i, jlo); /* bottom */
+					*tiled_value(conc, i, jhi+1) = *tiled_value(conc, i, jhi); /* top */
+				}
+			}
+		);
+	}
+
+	/* Lambda function executed on each thread, refreshing the tile halos the next sweep reads */
+	tbb::parallel_for(tbb::blocked_range<int>(0, sweep_count(conc)),
+		[=](const tbb::blocked_range<int>& r) {
+			for (int k = r.begin(); k != r.end(); k++) {
+				const int tile = sweep_tile(conc, k);
+				refresh_tile_halo(conc, tile % conc->ntx, tile / conc->ntx);
+			}
+		}
+	);
+}
@@ -10,48 +10,79 @@
 
 #include <math.h>
 #include <tbb/tbb.h>
-#include <tbb/task_scheduler_init.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
 #include <tbb/blocked_range2d.h>
 #include "boundaries.h"
+#include "integrator.h"
 #include "mesh.h"
 #include "numerics.h"
+#include "tiles.h"
 #include "timer.h"
+#include "trace.h"
+#include "stencil.h" /* after trace.h, so its blocks are traced */
 
 void compute_convolution(fp_t** conc_old, fp_t** conc_lap, fp_t** mask_lap,
                          const int nx, const int ny, const int nm)
 {
-	/* Lambda function executed on each thread, solving convolution	*/
-	tbb::parallel_for(tbb::blocked_range2d<int>(nm/2, nx-nm/2, nm/2, ny-nm/2),
-		[=](const tbb::blocked_range2d<int>& r) {
-			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
-				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
-					fp_t value = 0.0;
-					for (int mj = -nm/2; mj < nm/2+1; mj++) {
-						for (int mi = -nm/2; mi < nm/2+1; mi++) {
-							value += mask_lap[mj+nm/2][mi+nm/2] * conc_old[j+mj][i+mi];
-						}
-					}
-					conc_lap[j][i] = value;
-				}
-			}
-		}
-	);
+	/* whole rows, a few at a time: the inner loop vectorizes along them */
+	const stencil::TBB exec = {{nx, 4}, NULL};
+	stencil::convolve(exec, conc_old, conc_lap, mask_lap, nx, ny, nm);
 }
 
 void update_composition(fp_t** conc_old, fp_t** conc_lap, fp_t** conc_new,
                         const int nx, const int ny, const int nm,
 						const fp_t D, const fp_t dt)
 {
-	/* Lambda function executed on each thread, updating diffusion equation */
+	const stencil::TBB exec = {{nx, 4}, NULL};
+	stencil::update(exec, conc_old, conc_lap, conc_new, nx, ny, nm, D, dt);
+}
+
+void solve_tiles_affinity(fp_t** conc_old, fp_t** conc_new, fp_t** mask_lap,
+                          const int nx, const int ny, const int nm,
+                          const int bx, const int by, const fp_t D, const fp_t dt)
+{
+	/* Both persist across steps: the arena keeps one set of workers, and the
+	   partitioner replays the thread that swept each tile last time, whose
+	   cache still holds that tile's rows */
+	static tbb::task_arena arena;
+	static tbb::affinity_partitioner affinity;
+
+	arena.execute([&] {
+		const unsigned long long start = trace_begin();
+		apply_boundary_conditions(conc_old, nx, ny, nm);
+		trace_end("boundaries", -1, start);
+
+		/* convolve and update each tile of at most by rows and bx columns,
+		   so conc_lap is never stored */
+		const stencil::TBB exec = {{bx, by}, &affinity};
+		stencil::convolve_update(exec, conc_old, conc_new, mask_lap, nx, ny, nm, D, dt);
+	});
+}
+
+void combine_stages(fp_t** out,
+                    const fp_t c0, fp_t** y0, const fp_t c1, fp_t** y1, const fp_t c2, fp_t** y2,
+                    const fp_t c3, fp_t** l0, const fp_t c4, fp_t** l1,
+                    const int nx, const int ny, const int nm)
+{
+	/* Lambda function executed on each thread, combining integrator stages */
 	tbb::parallel_for(tbb::blocked_range2d<int>(nm/2, nx-nm/2, nm/2, ny-nm/2),
 		[=](const tbb::blocked_range2d<int>& r) {
+			const unsigned long long start = trace_begin();
 			for (int j = r.cols().begin(); j != r.cols().end(); j++) {
 				for (int i = r.rows().begin(); i != r.rows().end(); i++) {
-					conc_new[j][i] = conc_old[j][i] + dt * D * conc_lap[j][i];
+					fp_t value = 0.0;
+					if (y0 != NULL) value += c0 * y0[j][i];
+					if (y1 != NULL) value += c1 * y1[j][i];
+					if (y2 != NULL) value += c2 * y2[j][i];
+					if (l0 != NULL) value += c3 * l0[j][i];
+					if (l1 != NULL) value += c4 * l1[j][i];
+					out[j][i] = value;
 				}
 			}
+			trace_end("update", -1, start);
 		}
 	);
 }
@@ -125,3 +156,66 @@ void check_solution_lambda(fp_t** conc_new, fp_t** conc_lap, const int nx, const
 		}
 	);
 }
+
+void compute_convolution_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                               fp_t** mask_lap, const int nm)
+{
+	if (conc_old->curve == TILE_ORDER_ROWS && conc_old->activity == NULL) {
+		/* Lambda function executed on each thread, convolving whole tiles */
+		tbb::parallel_for(tbb::blocked_range2d<int>(0, conc_old->ntx, 0, conc_old->nty),
+			[=](const tbb::blocked_range2d<int>& r) {
+				for (int tj = r.cols().begin(); tj != r.cols().end(); tj++) {
+					for (int ti = r.rows().begin(); ti != r.rows().end(); ti++) {
+						convolve_tile(conc_old, conc_lap, mask_lap, nm, ti, tj);
+					}
+				}
+			}
+		);
+	} else {
+		/* Lambda function executed on each thread, convolving a contiguous run of tile order,
+		   active tiles only if conc_old tracks activity */
+		const int ntx = conc_old->ntx;
+		tbb::parallel_for(tbb::blocked_range<int>(0, sweep_count(conc_old)),
+			[=](const tbb::blocked_range<int>& r) {
+				for (int k = r.begin(); k != r.end(); k++) {
+					const int ti = sweep_tile(conc_old, k) % ntx;
+					const int tj = sweep_tile(conc_old, k) / ntx;
+					convolve_tile(conc_old, conc_lap, mask_lap, nm, ti, tj);
+				}
+			},
+			tbb::static_partitioner()
+		);
+	}
+}
+
+void update_composition_tiled(struct Tiles* conc_old, struct Tiles* conc_lap,
+                              struct Tiles* conc_new, const int nm,
+                              const fp_t D, const fp_t dt)
+{
+	if (conc_old->curve == TILE_ORDER_ROWS && conc_old->activity == NULL) {
+		/* Lambda function executed on each thread, updating whole tiles */
+		tbb::parallel_for(tbb::blocked_range2d<int>(0, conc_old->ntx, 0, conc_old->nty),
+			[=](const tbb::blocked_range2d<int>& r) {
+				for (int tj = r.cols().begin(); tj != r.cols().end(); tj++) {
+					for (int ti = r.rows().begin(); ti != r.rows().end(); ti++) {
+						update_tile(conc_old, conc_lap, conc_new, nm, ti, tj, D, dt);
+					}
+				}
+			}
+		);
+	} else {
+		/* Lambda function executed on each thread, updating a contiguous run of tile order,
+		   active tiles only if conc_old tracks activity */
+		const int ntx = conc_old->ntx;
+		tbb::parallel_for(tbb::blocked_range<int>(0, sweep_count(conc_old)),
+			[=](const tbb::blocked_range<int>& r) {
+				for (int k = r.begin(); k != r.end(); k++) {
+					const int ti = sweep_tile(conc_old, k) % ntx;
+					const int tj = sweep_tile(conc_old, k) / ntx;
+					update_tile(conc_old, conc_lap, conc_new, nm, ti, tj, D, dt);
+				}
+			},
+			tbb::static_partitioner()
+		);
+	}
+}
@@ -0,0 +1,258 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  tbb_pipeline.cpp
+ \brief Implementation of the TBB flow graph that checks and writes checkpoints off the stepping thread
+*/
+
+#include <stdlib.h>
+#include <tuple>
+#include <vector>
+#include <tbb/concurrent_queue.h>
+#include <tbb/flow_graph.h>
+#include "counters.h"
+#include "output.h"
+#include "tbb_pipeline.h"
+#include "timer.h"
+#include "trace.h"
+
+void check_solution_lambda(fp_t** conc_new, fp_t** conc_lap, const int nx, const int ny,
+						   const fp_t dx, const fp_t dy, const int nm, const fp_t elapsed, const fp_t D,
+						   fp_t* rss);
+
+/**
+ \brief One checkpoint in flight: a copy of the field, scratch for the residual, and the log state of its step
+*/
+struct Snapshot {
+	fp_t** conc;
+	fp_t** scratch;
+	int step;
+	fp_t elapsed;
+	fp_t active;
+	fp_t rss;
+	double soln_time;
+	double file_time;
+	struct Stopwatch watch;
+	struct Sampler sampler;
+};
+
+/** \cond SuppressGuard */
+typedef tbb::flow::function_node<Snapshot*, Snapshot*> StageNode;
+typedef tbb::flow::join_node<std::tuple<Snapshot*, Snapshot*>, tbb::flow::queueing> PairNode;
+typedef tbb::flow::function_node<std::tuple<Snapshot*, Snapshot*>, tbb::flow::continue_msg> LogNode;
+/** \endcond */
+
+struct Pipeline {
+	FILE* output;
+	int nx, ny, nm, stages;
+	fp_t dx, dy, D;
+	struct Roofline roof;
+
+	/* written only by the logger node */
+	double soln_time, file_time;
+	fp_t rss;
+
+	std::vector<Snapshot> snapshots;
+	tbb::concurrent_bounded_queue<Snapshot*> pool;
+	Snapshot* pending;
+
+	tbb::flow::graph graph;
+	tbb::flow::broadcast_node<Snapshot*>* source;
+	StageNode* diagnose;
+	StageNode* draw;
+	PairNode* join;
+	LogNode* logger;
+};
+
+/**
+ \brief Allocate an \a nx by \a ny field with row pointers, as make_arrays() does
+*/
+static fp_t** make_field(const int nx, const int ny)
+{
+	fp_t** field = (fp_t**)calloc(ny, sizeof(fp_t*));
+	fp_t* data = (fp_t*)calloc(nx * ny, sizeof(fp_t));
+
+	if (field == NULL || data == NULL) {
+		printf("Error: unable to allocate %i x %i checkpoint.\n", nx, ny);
+		exit(-1);
+	}
+
+	for (int j = 0; j < ny; j++)
+		field[j] = &data[nx * j];
+
+	return field;
+}
+
+/**
+ \brief Free a field from make_field()
+*/
+static void free_field(fp_t** field)
+{
+	free(field[0]);
+	free(field);
+}
+
+/**
+ \brief Append the runlog row of \a snap, with the checkpoint times accumulated so far
+*/
+static void log_snapshot(struct Pipeline* pipe, Snapshot* snap)
+{
+	struct Stopwatch watch = snap->watch;
+
+	pipe->soln_time += snap->soln_time;
+	pipe->file_time += snap->file_time;
+	pipe->rss = snap->rss;
+	watch.soln += pipe->soln_time;
+	watch.file += pipe->file_time;
+
+	const unsigned long long start = trace_begin();
+	fprintf(pipe->output, "%i,%f,%f,%f,%f,%f,%f,%f", snap->step, snap->elapsed, snap->rss,
+			watch.conv, watch.step, watch.file, watch.soln, GetTimer());
+	print_sampling(pipe->output, &snap->sampler);
+	print_roofline(pipe->output, &pipe->roof, &watch, snap->step * pipe->stages);
+	print_counters(pipe->output, &watch);
+	fprintf(pipe->output, ",%f\n", snap->active);
+	fflush(pipe->output);
+	trace_end("runlog", -1, start);
+}
+
+struct Pipeline* open_pipeline(FILE* output, const int depth,
+                               const int nx, const int ny, const fp_t dx, const fp_t dy,
+                               const int nm, const fp_t D,
+                               const struct Roofline* roof, const int stages)
+{
+	struct Pipeline* pipe = new Pipeline;
+
+	if (depth < 1) {
+		printf("Error: checkpoint pipeline depth %i must be positive.\n", depth);
+		exit(-1);
+	}
+
+	pipe->output = output;
+	pipe->nx = nx;
+	pipe->ny = ny;
+	pipe->nm = nm;
+	pipe->stages = stages;
+	pipe->dx = dx;
+	pipe->dy = dy;
+	pipe->D = D;
+	pipe->roof = *roof;
+	pipe->soln_time = 0.;
+	pipe->file_time = 0.;
+	pipe->rss = 0.;
+	pipe->pending = NULL;
+
+	pipe->snapshots.resize(depth);
+	for (int k = 0; k < depth; k++) {
+		pipe->snapshots[k].conc = make_field(nx, ny);
+		pipe->snapshots[k].scratch = make_field(nx, ny);
+		pipe->pool.push(&pipe->snapshots[k]);
+	}
+
+	pipe->source = new tbb::flow::broadcast_node<Snapshot*>(pipe->graph);
+
+	/* residual against the analytical solution */
+	pipe->diagnose = new StageNode(pipe->graph, tbb::flow::serial,
+		[pipe](Snapshot* snap) -> Snapshot* {
+			timer_push("check_solution");
+			const unsigned long long start = trace_begin();
+			check_solution_lambda(snap->conc, snap->scratch, pipe->nx, pipe->ny, pipe->dx, pipe->dy,
+			                      pipe->nm, snap->elapsed, pipe->D, &snap->rss);
+			trace_end("check_solution", -1, start);
+			snap->soln_time = timer_pop();
+			return snap;
+		}
+	);
+
+	/* image of the field */
+	pipe->draw = new StageNode(pipe->graph, tbb::flow::serial,
+		[pipe](Snapshot* snap) -> Snapshot* {
+			timer_push("write_png");
+			const unsigned long long start = trace_begin();
+			write_png(snap->conc, pipe->nx, pipe->ny, snap->step);
+			trace_end("write_png", -1, start);
+			snap->file_time = timer_pop();
+			return snap;
+		}
+	);
+
+	/* both stages are serial and fed in step order, so the queueing join
+	   pairs the two halves of the same snapshot */
+	pipe->join = new PairNode(pipe->graph);
+
+	pipe->logger = new LogNode(pipe->graph, tbb::flow::serial,
+		[pipe](const std::tuple<Snapshot*, Snapshot*>& pair) -> tbb::flow::continue_msg {
+			Snapshot* snap = std::get<0>(pair);
+			log_snapshot(pipe, snap);
+			pipe->pool.push(snap);
+			return tbb::flow::continue_msg();
+		}
+	);
+
+	tbb::flow::make_edge(*pipe->source, *pipe->diagnose);
+	tbb::flow::make_edge(*pipe->source, *pipe->draw);
+	tbb::flow::make_edge(*pipe->diagnose, tbb::flow::input_port<0>(*pipe->join));
+	tbb::flow::make_edge(*pipe->draw, tbb::flow::input_port<1>(*pipe->join));
+	tbb::flow::make_edge(*pipe->join, *pipe->logger);
+
+	return pipe;
+}
+
+fp_t** checkpoint_field(struct Pipeline* pipe)
+{
+	if (pipe->pending == NULL && !pipe->pool.try_pop(pipe->pending)) {
+		/* every snapshot is in flight: help drain the graph rather than block,
+		   since there may be no worker threads to run it */
+		timer_push("checkpoint wait");
+		pipe->graph.wait_for_all();
+		pipe->pool.pop(pipe->pending);
+		timer_pop();
+	}
+	return pipe->pending->conc;
+}
+
+void submit_checkpoint(struct Pipeline* pipe, const int step, const fp_t elapsed,
+                       const struct Stopwatch* watch, const struct Sampler* sampler,
+                       const fp_t active)
+{
+	Snapshot* snap = pipe->pending;
+
+	if (snap == NULL) {
+		printf("Error: checkpoint submitted without checkpoint_field().\n");
+		exit(-1);
+	}
+
+	snap->step = step;
+	snap->elapsed = elapsed;
+	snap->active = active;
+	snap->watch = *watch;
+	snap->sampler = *sampler;
+	pipe->pending = NULL;
+
+	pipe->source->try_put(snap);
+}
+
+void close_pipeline(struct Pipeline* pipe, struct Stopwatch* watch, fp_t* rss)
+{
+	pipe->graph.wait_for_all();
+
+	watch->soln += pipe->soln_time;
+	watch->file += pipe->file_time;
+	*rss = pipe->rss;
+
+	delete pipe->logger;
+	delete pipe->join;
+	delete pipe->draw;
+	delete pipe->diagnose;
+	delete pipe->source;
+
+	for (size_t k = 0; k < pipe->snapshots.size(); k++) {
+		free_field(pipe->snapshots[k].conc);
+		free_field(pipe->snapshots[k].scratch);
+	}
+
+	delete pipe;
+}
@@ -0,0 +1,67 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  tbb_pipeline.h
+ \brief Declaration of the TBB flow graph that checks and writes checkpoints off the stepping thread
+*/
+
+/** \cond SuppressGuard */
+#ifndef _TBB_PIPELINE_H_
+#define _TBB_PIPELINE_H_
+/** \endcond */
+
+#include <stdio.h>
+#include "roofline.h"
+#include "sampling.h"
+#include "type.h"
+
+/**
+ \brief Flow graph, snapshot pool, and runlog state; defined in tbb_pipeline.cpp
+*/
+struct Pipeline;
+
+/**
+ \brief Build the checkpoint graph, with \a depth snapshots of the \a nx by \a ny field in flight
+
+ Each submitted snapshot is broadcast to a diagnostic node, which computes
+ the residual with check_solution_lambda(), and to an output node, which
+ calls write_png(). Both are serial, so snapshots leave them in order; a join
+ pairs their results and a logger node appends the row to \a output, then
+ returns the snapshot to the pool. The pool bounds memory to \a depth
+ snapshots of two fields each. Rows carry the roofline of \a roof over
+ \a stages kernel calls per step.
+*/
+struct Pipeline* open_pipeline(FILE* output, const int depth,
+                               const int nx, const int ny, const fp_t dx, const fp_t dy,
+                               const int nm, const fp_t D,
+                               const struct Roofline* roof, const int stages);
+
+/**
+ \brief Field to copy the next checkpoint into, waiting until a snapshot is free
+*/
+fp_t** checkpoint_field(struct Pipeline* pipe);
+
+/**
+ \brief Send the field from checkpoint_field() into the graph and return at once
+
+ The kernel times in \a watch, the sampling state, and the \a active tile
+ fraction are copied as of this step, so the runlog row matches a serial run.
+*/
+void submit_checkpoint(struct Pipeline* pipe, const int step, const fp_t elapsed,
+                       const struct Stopwatch* watch, const struct Sampler* sampler,
+                       const fp_t active);
+
+/**
+ \brief Wait for every checkpoint, then free the graph
+
+ Adds the time spent writing and checking to \a watch and stores the last
+ residual in \a rss.
+*/
+void close_pipeline(struct Pipeline* pipe, struct Stopwatch* watch, fp_t* rss);
+
+/** \cond SuppressGuard */
+#endif /* _TBB_PIPELINE_H_ */
+/** \endcond */
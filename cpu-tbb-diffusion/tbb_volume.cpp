@@ -0,0 +1,161 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  tbb_volume.cpp
+ \brief Implementation of 3D boundary condition and discretization functions with TBB threading
+*/
+
+#include <vector>
+#include <tbb/tbb.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/blocked_range2d.h>
+#include "volume.h"
+
+void apply_initial_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm)
+{
+	/* Lambda function executed on each thread, applying flat field and wall values */
+	tbb::parallel_for(tbb::blocked_range<int>(0, nz),
+		[=](const tbb::blocked_range<int>& r) {
+			for (int k = r.begin(); k != r.end(); k++) {
+				for (int j = 0; j < ny; j++) {
+					for (int i = 0; i < nx; i++) {
+						conc[k][j][i] = 0.;
+					}
+				}
+				if (k < nz/2) {
+					for (int j = 0; j < ny/2; j++)
+						for (int i = 0; i < 1+nm/2; i++)
+							conc[k][j][i] = 1.; /* left quarter-wall */
+				} else {
+					for (int j = ny/2; j < ny; j++)
+						for (int i = nx-1-nm/2; i < nx; i++)
+							conc[k][j][i] = 1.; /* right quarter-wall */
+				}
+			}
+		}
+	);
+}
+
+void apply_boundary_conditions_3d(fp_t*** conc, const int nx, const int ny, const int nz, const int nm)
+{
+	/* Lambda function executed on each thread, applying fixed values, then
+	   no-flux conditions along x and y: planes are independent */
+	tbb::parallel_for(tbb::blocked_range<int>(0, nz),
+		[=](const tbb::blocked_range<int>& r) {
+			for (int k = r.begin(); k != r.end(); k++) {
+				if (k < nz/2) {
+					for (int j = 0; j < ny/2; j++)
+						for (int i = 0; i < 1+nm/2; i++)
+							conc[k][j][i] = 1.; /* left value */
+				} else {
+					for (int j = ny/2; j < ny; j++)
+						for (int i = nx-1-nm/2; i < nx; i++)
+							conc[k][j][i] = 1.; /* right value */
+				}
+
+				for (int offset = 0; offset < nm/2; offset++) {
+					const int ilo = nm/2 - offset;
+					const int ihi = nx - 1 - nm/2 + offset;
+					for (int j = 0; j < ny; j++) {
+						conc[k][j][ilo-1] = conc[k][j][ilo]; /* left condition */
+						conc[k][j][ihi+1] = conc[k][j][ihi]; /* right condition */
+					}
+				}
+
+				for (int offset = 0; offset < nm/2; offset++) {
+					const int jlo = nm/2 - offset;
+					const int jhi = ny - 1 - nm/2 + offset;
+					for (int i = 0; i < nx; i++) {
+						conc[k][jlo-1][i] = conc[k][jlo][i]; /* bottom condition */
+						conc[k][jhi+1][i] = conc[k][jhi][i]; /* top condition */
+					}
+				}
+			}
+		}
+	);
+
+	/* Lambda function executed on each thread, applying no-flux conditions along z */
+	tbb::parallel_for(tbb::blocked_range<int>(0, ny),
+		[=](const tbb::blocked_range<int>& r) {
+			for (int offset = 0; offset < nm/2; offset++) {
+				const int klo = nm/2 - offset;
+				const int khi = nz - 1 - nm/2 + offset;
+				for (int j = r.begin(); j != r.end(); j++) {
+					for (int i = 0; i < nx; i++) {
+						conc[klo-1][j][i] = conc[klo][j][i]; /* back condition */
+						conc[khi+1][j][i] = conc[khi][j][i]; /* front condition */
+					}
+				}
+			}
+		}
+	);
+}
+
+void compute_convolution_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                            const int nx, const int ny, const int nz, const int nm)
+{
+	/* Lambda function executed on each thread, solving convolution	*/
+	tbb::parallel_for(tbb::blocked_range2d<int>(nm/2, nz-nm/2, nm/2, ny-nm/2),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int k = r.rows().begin(); k != r.rows().end(); k++) {
+				for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+					for (int i = nm/2; i < nx-nm/2; i++) {
+						fp_t value = 0.0;
+						for (int mk = -nm/2; mk < nm/2+1; mk++) {
+							for (int mj = -nm/2; mj < nm/2+1; mj++) {
+								for (int mi = -nm/2; mi < nm/2+1; mi++) {
+									value += mask_lap[mk+nm/2][mj+nm/2][mi+nm/2] * conc_old[k+mk][j+mj][i+mi];
+								}
+							}
+						}
+						conc_lap[k][j][i] = value;
+					}
+				}
+			}
+		}
+	);
+}
+
+void compute_convolution_3d_blocked(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** mask_lap,
+                                    const int nx, const int ny, const int nz, const int nm,
+                                    const int bx, const int by)
+{
+	/* Lambda function executed on each thread, streaming whole xy tiles along z */
+	tbb::parallel_for(tbb::blocked_range2d<int>(0, (ny - 2 * (nm/2) + by - 1) / by,
+	                                            0, (nx - 2 * (nm/2) + bx - 1) / bx),
+		[=](const tbb::blocked_range2d<int>& r) {
+			std::vector<fp_t> queue(column_buffer_size(bx, by, nm));
+			for (int ty = r.rows().begin(); ty != r.rows().end(); ty++) {
+				for (int tx = r.cols().begin(); tx != r.cols().end(); tx++) {
+					const int x0 = nm/2 + bx * tx;
+					const int y0 = nm/2 + by * ty;
+					const int x1 = (x0 + bx < nx-nm/2) ? x0 + bx : nx-nm/2;
+					const int y1 = (y0 + by < ny-nm/2) ? y0 + by : ny-nm/2;
+					convolve_column(conc_old, conc_lap, mask_lap, nz, nm, x0, x1, y0, y1, queue.data());
+				}
+			}
+		}
+	);
+}
+
+void update_composition_3d(fp_t*** conc_old, fp_t*** conc_lap, fp_t*** conc_new,
+                           const int nx, const int ny, const int nz, const int nm,
+                           const fp_t D, const fp_t dt)
+{
+	/* Lambda function executed on each thread, updating diffusion equation */
+	tbb::parallel_for(tbb::blocked_range2d<int>(nm/2, nz-nm/2, nm/2, ny-nm/2),
+		[=](const tbb::blocked_range2d<int>& r) {
+			for (int k = r.rows().begin(); k != r.rows().end(); k++) {
+				for (int j = r.cols().begin(); j != r.cols().end(); j++) {
+					for (int i = nm/2; i < nx-nm/2; i++) {
+						conc_new[k][j][i] = conc_old[k][j][i] + dt * D * conc_lap[k][j][i];
+					}
+				}
+			}
+		}
+	);
+}
@@ -0,0 +1,307 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  ws.c
+ \brief Implementation of the work-stealing tile scheduler
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ws.h"
+
+/**
+ \brief Returned by take_task() and steal_task() when the deque is empty
+*/
+#define WS_EMPTY -1
+
+/**
+ \brief Returned by steal_task() when another thief won the race
+*/
+#define WS_ABORT -2
+
+/**
+ \brief Owner: push a task at the bottom
+*/
+static void push_task(struct Deque* d, const long task)
+{
+	const long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+
+	atomic_store_explicit(&d->tasks[b & d->mask], task, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+/**
+ \brief Owner: take the most recently pushed task
+*/
+static long take_task(struct Deque* d)
+{
+	const long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+	long t, task = WS_EMPTY;
+
+	atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+	if (t <= b) {
+		task = atomic_load_explicit(&d->tasks[b & d->mask], memory_order_relaxed);
+		if (t == b) {
+			/* last task: race the thieves for it */
+			if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+			                                             memory_order_seq_cst, memory_order_relaxed))
+				task = WS_EMPTY;
+			atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+		}
+	} else {
+		atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+	}
+
+	return task;
+}
+
+/**
+ \brief Thief: take the oldest task
+*/
+static long steal_task(struct Deque* d)
+{
+	long t = atomic_load_explicit(&d->top, memory_order_acquire);
+	long b, task;
+
+	atomic_thread_fence(memory_order_seq_cst);
+	b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+	if (t >= b)
+		return WS_EMPTY;
+
+	task = atomic_load_explicit(&d->tasks[t & d->mask], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+	                                             memory_order_seq_cst, memory_order_relaxed))
+		return WS_ABORT;
+
+	return task;
+}
+
+/**
+ \brief Run one task, then release the neighbors' next step
+
+ Rearms this tile's countdown for two steps ahead before running: no
+ neighbor can finish step \a s + 1 until this tile finishes step \a s.
+*/
+static void run_task(struct Scheduler* sched, struct Deque* own, const long task)
+{
+	const int tile = task % sched->ntiles;
+	const int step = task / sched->ntiles;
+	const int ti = tile % sched->ntx;
+	const int tj = tile / sched->ntx;
+
+	atomic_store_explicit(&sched->pending[(step % 2) * sched->ntiles + tile],
+	                      sched->neighbors[tile], memory_order_relaxed);
+
+	sched->task(sched->context, tile, step);
+
+	if (step + 1 < sched->steps) {
+		atomic_int* next = &sched->pending[((step + 1) % 2) * sched->ntiles];
+		for (int nj = (tj > 0) ? tj - 1 : 0; nj < tj + 2 && nj < sched->nty; nj++) {
+			for (int ni = (ti > 0) ? ti - 1 : 0; ni < ti + 2 && ni < sched->ntx; ni++) {
+				const int n = ni + sched->ntx * nj;
+				/* acq_rel: the last neighbor in sees every other's writes */
+				if (atomic_fetch_sub_explicit(&next[n], 1, memory_order_acq_rel) == 1)
+					push_task(own, n + (long)sched->ntiles * (step + 1));
+			}
+		}
+	}
+
+	atomic_fetch_sub_explicit(&sched->remaining, 1, memory_order_release);
+}
+
+/**
+ \brief Worker loop: drain the own deque, then steal round-robin, until the run is done
+*/
+static void* work(void* arg)
+{
+	struct Worker* worker = (struct Worker*)arg;
+	struct Scheduler* sched = worker->sched;
+	struct Deque* own = &sched->deques[worker->id];
+
+	while (atomic_load_explicit(&sched->remaining, memory_order_acquire) > 0) {
+		long task = take_task(own);
+
+		for (int k = 1; task < 0 && k < sched->nthreads; k++) {
+			task = steal_task(&sched->deques[(worker->id + k) % sched->nthreads]);
+			if (task >= 0)
+				atomic_fetch_add_explicit(&sched->steals, 1, memory_order_relaxed);
+		}
+
+		if (task >= 0)
+			run_task(sched, own, task);
+		else
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+/**
+ \brief Body of a parked worker thread: wait for a new ws_run(), work it, report, repeat
+*/
+static void* serve(void* arg)
+{
+	struct Worker* worker = (struct Worker*)arg;
+	struct Scheduler* sched = worker->sched;
+	int seen = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&sched->lock);
+		while (sched->generation == seen && !sched->quit)
+			pthread_cond_wait(&sched->wake, &sched->lock);
+		if (sched->quit) {
+			pthread_mutex_unlock(&sched->lock);
+			return NULL;
+		}
+		seen = sched->generation;
+		pthread_mutex_unlock(&sched->lock);
+
+		work(worker);
+		atomic_fetch_add_explicit(&sched->finished, 1, memory_order_release);
+	}
+}
+
+void make_scheduler(struct Scheduler* sched, const int nthreads, const int ntx, const int nty)
+{
+	long capacity = 1;
+
+	if (nthreads < 1) {
+		printf("Error: the scheduler needs at least one worker, not %i.\n", nthreads);
+		exit(-1);
+	}
+
+	sched->nthreads = nthreads;
+	sched->ntx = ntx;
+	sched->nty = nty;
+	sched->ntiles = ntx * nty;
+
+	while (capacity < sched->ntiles)
+		capacity *= 2;
+
+	sched->deques = (struct Deque*)calloc(nthreads, sizeof(struct Deque));
+	sched->pending = (atomic_int*)calloc(2 * sched->ntiles, sizeof(atomic_int));
+	sched->neighbors = (int*)calloc(sched->ntiles, sizeof(int));
+
+	if (sched->deques == NULL || sched->pending == NULL || sched->neighbors == NULL) {
+		printf("Error: unable to allocate scheduler for %i tiles.\n", sched->ntiles);
+		exit(-1);
+	}
+
+	for (int w = 0; w < nthreads; w++) {
+		sched->deques[w].tasks = (atomic_long*)calloc(capacity, sizeof(atomic_long));
+		sched->deques[w].mask = capacity - 1;
+		atomic_init(&sched->deques[w].top, 0);
+		atomic_init(&sched->deques[w].bottom, 0);
+		if (sched->deques[w].tasks == NULL) {
+			printf("Error: unable to allocate deque of %li tasks.\n", capacity);
+			exit(-1);
+		}
+	}
+
+	/* tiles in the 3x3 neighborhood, fewer along the edges */
+	for (int tj = 0; tj < nty; tj++) {
+		for (int ti = 0; ti < ntx; ti++) {
+			const int across = 1 + (ti > 0) + (ti < ntx - 1);
+			const int down = 1 + (tj > 0) + (tj < nty - 1);
+			sched->neighbors[ti + ntx * tj] = across * down;
+		}
+	}
+
+	atomic_init(&sched->remaining, 0);
+	atomic_init(&sched->steals, 0);
+	atomic_init(&sched->finished, 0);
+
+	sched->workers = (struct Worker*)calloc(nthreads, sizeof(struct Worker));
+	sched->threads = (pthread_t*)calloc(nthreads, sizeof(pthread_t));
+	if (sched->workers == NULL || sched->threads == NULL) {
+		printf("Error: unable to allocate %i workers.\n", nthreads);
+		exit(-1);
+	}
+	pthread_mutex_init(&sched->lock, NULL);
+	pthread_cond_init(&sched->wake, NULL);
+	sched->generation = 0;
+	sched->quit = 0;
+
+	for (int w = 0; w < nthreads; w++) {
+		sched->workers[w].sched = sched;
+		sched->workers[w].id = w;
+	}
+
+	for (int w = 1; w < nthreads; w++) {
+		if (pthread_create(&sched->threads[w], NULL, serve, &sched->workers[w]) != 0) {
+			printf("Error: unable to start worker %i.\n", w);
+			exit(-1);
+		}
+	}
+}
+
+void free_scheduler(struct Scheduler* sched)
+{
+	pthread_mutex_lock(&sched->lock);
+	sched->quit = 1;
+	pthread_cond_broadcast(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+
+	for (int w = 1; w < sched->nthreads; w++)
+		pthread_join(sched->threads[w], NULL);
+
+	pthread_mutex_destroy(&sched->lock);
+	pthread_cond_destroy(&sched->wake);
+	free(sched->workers);
+	free(sched->threads);
+	for (int w = 0; w < sched->nthreads; w++)
+		free(sched->deques[w].tasks);
+	free(sched->deques);
+	free(sched->pending);
+	free(sched->neighbors);
+}
+
+void ws_run(struct Scheduler* sched, ws_task task, void* context, const int steps)
+{
+	const int n = sched->nthreads;
+
+	if (steps < 1)
+		return;
+
+	sched->task = task;
+	sched->context = context;
+	sched->steps = steps;
+	atomic_store(&sched->remaining, (long)sched->ntiles * steps);
+
+	/* step 1 waits on every neighbor's step 0 */
+	for (int t = 0; t < sched->ntiles; t++)
+		atomic_store(&sched->pending[sched->ntiles + t], sched->neighbors[t]);
+
+	/* seed each worker with a band of whole tile rows, pushed in reverse so
+	   the owner starts at the top of its band and thieves take from the end */
+	for (int w = 0; w < n; w++) {
+		const int first = (int)((long)sched->nty * w / n) * sched->ntx;
+		const int last = (int)((long)sched->nty * (w + 1) / n) * sched->ntx;
+		atomic_store(&sched->deques[w].top, 0);
+		atomic_store(&sched->deques[w].bottom, 0);
+		for (int t = last - 1; t >= first; t--)
+			push_task(&sched->deques[w], t);
+	}
+
+	pthread_mutex_lock(&sched->lock);
+	sched->generation++;
+	pthread_cond_broadcast(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+
+	work(&sched->workers[0]);
+
+	/* nobody may still be stealing when the next run reseeds the deques */
+	while (atomic_load_explicit(&sched->finished, memory_order_acquire) < n - 1)
+		sched_yield();
+	atomic_store(&sched->finished, 0);
+}
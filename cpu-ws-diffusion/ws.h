@@ -0,0 +1,164 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  ws.h
+ \brief Declaration of a work-stealing tile scheduler and the diffusion sweeps built on it
+*/
+
+/** \cond SuppressGuard */
+#ifndef _WS_H_
+#define _WS_H_
+/** \endcond */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "type.h"
+
+/**
+ \brief Chase-Lev deque of tasks, owned by one worker
+
+ The owner pushes and takes at the bottom without locks; other workers steal
+ from the top, contending only through a compare-and-swap on \a top when one
+ task is left. Capacity is fixed: a tile is never queued twice at once, so
+ one slot per tile suffices.
+*/
+struct Deque {
+	/**
+	 Next slot to steal from, and one past the last slot pushed
+	*/
+	atomic_long top, bottom;
+
+	/**
+	 Ring of encoded tasks, tile + ntiles \f$\times\f$ step, of \a mask + 1 slots
+	*/
+	atomic_long* tasks;
+
+	/**
+	 Capacity minus one, a power of two less one
+	*/
+	long mask;
+};
+
+/**
+ \brief Function run for one tile on one step; \a context is passed through from ws_run()
+*/
+typedef void (*ws_task)(void* context, const int tile, const int step);
+
+/**
+ \brief Worker of a struct Scheduler; index 0 is the thread calling ws_run()
+*/
+struct Worker {
+	struct Scheduler* sched;
+	int id;
+};
+
+/**
+ \brief Pool of workers sweeping a \a ntx \f$\times\f$ \a nty grid of tiles
+
+ ws_run() seeds each worker's deque with a contiguous band of tile rows, so
+ neighboring tiles start on the same thread. A tile may begin step \a s once
+ the tiles around it, itself included, have finished step \a s - 1: each
+ tile and step parity has an atomic countdown that finishing neighbors
+ decrement, and whichever worker takes it to zero pushes the tile onto its
+ own deque, where the neighbor's data is still in cache. Idle workers steal
+ from the others. The worker threads persist between calls, parked on a
+ condition variable, so trace slots and first-touch placement carry over.
+*/
+struct Scheduler {
+	/**
+	 Workers, including the calling thread
+	*/
+	int nthreads;
+
+	/**
+	 Tile grid and tile count
+	*/
+	int ntx, nty, ntiles;
+
+	/**
+	 One deque per worker
+	*/
+	struct Deque* deques;
+
+	/**
+	 Countdowns of neighbors yet to finish the previous step, two per tile
+	 indexed by step parity, and the neighborhood size that rearms them
+	*/
+	atomic_int* pending;
+	int* neighbors;
+
+	/**
+	 Tasks of the current ws_run() not yet finished
+	*/
+	atomic_long remaining;
+
+	/**
+	 Tasks taken from another worker's deque, cumulative
+	*/
+	atomic_long steals;
+
+	/**
+	 Task function, context, and step count of the current ws_run()
+	*/
+	ws_task task;
+	void* context;
+	int steps;
+
+	/**
+	 Parked worker threads, woken when ws_run() advances \a generation
+	*/
+	struct Worker* workers;
+	pthread_t* threads;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	int generation, quit;
+
+	/**
+	 Workers other than the caller that have finished the current ws_run()
+	*/
+	atomic_int finished;
+};
+
+/**
+ \brief Allocate deques and countdowns for \a nthreads workers over \a ntx by \a nty tiles, and start the workers
+*/
+void make_scheduler(struct Scheduler* sched, const int nthreads, const int ntx, const int nty);
+
+/**
+ \brief Stop the workers and free the scheduler
+*/
+void free_scheduler(struct Scheduler* sched);
+
+/**
+ \brief Run \a task on every tile for steps 0 to \a steps - 1, each after its neighbors' previous step
+
+ Returns when every task has finished. With \a steps = 1 the tiles are
+ independent, and the scheduler simply balances one sweep.
+*/
+void ws_run(struct Scheduler* sched, ws_task task, void* context, const int steps);
+
+/**
+ \brief Apply initial conditions on \a bx by \a by tiles through the scheduler
+*/
+void ws_initial_conditions(struct Scheduler* sched, fp_t** conc,
+                           const int nx, const int ny, const int nm, const int bx, const int by);
+
+/**
+ \brief March \a steps forward Euler steps, tiles running ahead wherever their neighbors allow
+
+ Each task convolves and updates one tile, then applies the boundary
+ conditions to its share of the new field unless the step is the last, so
+ results match apply_boundary_conditions(), compute_convolution(), and
+ update_composition() step by step. The newest field is returned in
+ \a conc_old.
+*/
+void ws_march(struct Scheduler* sched, fp_t*** conc_old, fp_t*** conc_new, fp_t** mask_lap,
+              const int nx, const int ny, const int nm, const int bx, const int by,
+              const fp_t D, const fp_t dt, const int steps);
+
+/** \cond SuppressGuard */
+#endif /* _WS_H_ */
+/** \endcond */
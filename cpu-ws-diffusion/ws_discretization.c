@@ -0,0 +1,211 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  ws_discretization.c
+ \brief Implementation of the diffusion sweeps run by the work-stealing scheduler
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mesh.h"
+#include "trace.h"
+#include "ws.h"
+
+/**
+ \brief Tile geometry and fields shared by every task of one ws_run()
+*/
+struct Sweep {
+	fp_t** field[2];
+	fp_t** mask_lap;
+	int nx, ny, nm, bx, by, ntx, steps;
+	fp_t D, dt;
+};
+
+/**
+ \brief Interior bounds [\a x0, \a x1) by [\a y0, \a y1) of \a tile
+*/
+static void tile_bounds(const struct Sweep* sweep, const int tile, int* x0, int* x1, int* y0, int* y1)
+{
+	const int nm = sweep->nm;
+
+	*x0 = nm/2 + sweep->bx * (tile % sweep->ntx);
+	*y0 = nm/2 + sweep->by * (tile / sweep->ntx);
+	*x1 = (*x0 + sweep->bx < sweep->nx-nm/2) ? *x0 + sweep->bx : sweep->nx-nm/2;
+	*y1 = (*y0 + sweep->by < sweep->ny-nm/2) ? *y0 + sweep->by : sweep->ny-nm/2;
+}
+
+/**
+ \brief Apply the boundary conditions to the part of the field owned by one tile, as apply_boundary_conditions() does
+
+ Tiles along the domain edge own the halo beyond it. Within the tile the
+ order matches the whole-field sweep, so results agree bitwise.
+*/
+static void bound_tile(fp_t** conc, const int nx, const int ny, const int nm,
+                       const int x0, const int x1, const int y0, const int y1)
+{
+	const int ex0 = (x0 == nm/2) ? 0 : x0;
+	const int ex1 = (x1 == nx-nm/2) ? nx : x1;
+	const int ey0 = (y0 == nm/2) ? 0 : y0;
+	const int ey1 = (y1 == ny-nm/2) ? ny : y1;
+
+	for (int j = ey0; j < ey1; j++) {
+		for (int i = ex0; i < ex1; i++) {
+			if (j < ny/2 && i < 1+nm/2)
+				conc[j][i] = 1.; /* left value */
+			else if (j >= ny/2 && i >= nx-1-nm/2)
+				conc[j][i] = 1.; /* right value */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int ilo = nm/2 - offset;
+		const int ihi = nx - 1 - nm/2 + offset;
+		for (int j = ey0; j < ey1; j++) {
+			if (x0 == nm/2)
+				conc[j][ilo-1] = conc[j][ilo]; /* left condition */
+			if (x1 == nx-nm/2)
+				conc[j][ihi+1] = conc[j][ihi]; /* right condition */
+		}
+	}
+
+	for (int offset = 0; offset < nm/2; offset++) {
+		const int jlo = nm/2 - offset;
+		const int jhi = ny - 1 - nm/2 + offset;
+		for (int i = ex0; i < ex1; i++) {
+			if (y0 == nm/2)
+				conc[jlo-1][i] = conc[jlo][i]; /* bottom condition */
+			if (y1 == ny-nm/2)
+				conc[jhi+1][i] = conc[jhi][i]; /* top condition */
+		}
+	}
+}
+
+/**
+ \brief Task of ws_initial_conditions(): zero the tile and its edge halo, then raise the half-walls
+*/
+static void initial_task(void* context, const int tile, const int step)
+{
+	const struct Sweep* sweep = (const struct Sweep*)context;
+	const int nx = sweep->nx;
+	const int ny = sweep->ny;
+	const int nm = sweep->nm;
+	fp_t** conc = sweep->field[0];
+	int x0, x1, y0, y1;
+
+	tile_bounds(sweep, tile, &x0, &x1, &y0, &y1);
+	if (x0 == nm/2) x0 = 0;
+	if (x1 == nx-nm/2) x1 = nx;
+	if (y0 == nm/2) y0 = 0;
+	if (y1 == ny-nm/2) y1 = ny;
+
+	for (int j = y0; j < y1; j++) {
+		for (int i = x0; i < x1; i++) {
+			if (j < ny/2 && i < 1+nm/2)
+				conc[j][i] = 1.0; /* left half-wall */
+			else if (j >= ny/2 && i >= nx-1-nm/2)
+				conc[j][i] = 1.0; /* right half-wall */
+			else
+				conc[j][i] = 0.0;
+		}
+	}
+}
+
+/**
+ \brief Task of ws_march(): convolve and update one tile, then bound it for the next step
+*/
+static void march_task(void* context, const int tile, const int step)
+{
+	const struct Sweep* sweep = (const struct Sweep*)context;
+	const int nm = sweep->nm;
+	fp_t** src = sweep->field[step % 2];
+	fp_t** dst = sweep->field[(step + 1) % 2];
+	fp_t** mask_lap = sweep->mask_lap;
+	const unsigned long long start = trace_begin();
+	int x0, x1, y0, y1;
+
+	tile_bounds(sweep, tile, &x0, &x1, &y0, &y1);
+
+	for (int j = y0; j < y1; j++) {
+		for (int i = x0; i < x1; i++) {
+			fp_t value = 0.0;
+			for (int mj = -nm/2; mj < nm/2+1; mj++) {
+				for (int mi = -nm/2; mi < nm/2+1; mi++) {
+					value += mask_lap[mj+nm/2][mi+nm/2] * src[j+mj][i+mi];
+				}
+			}
+			dst[j][i] = src[j][i] + sweep->dt * sweep->D * value;
+		}
+	}
+
+	/* the caller bounds the field before the first step and after the last */
+	if (step + 1 < sweep->steps)
+		bound_tile(dst, sweep->nx, sweep->ny, nm, x0, x1, y0, y1);
+
+	trace_end("convolution", tile, start);
+}
+
+/**
+ \brief Fill the sweep shared by the tasks, checking that the tiles match the scheduler
+*/
+static void make_sweep(struct Sweep* sweep, const struct Scheduler* sched,
+                       const int nx, const int ny, const int nm, const int bx, const int by)
+{
+	const int ntx = (nx - 2 * (nm/2) + bx - 1) / bx;
+	const int nty = (ny - 2 * (nm/2) + by - 1) / by;
+
+	if (bx < nm/2 || by < nm/2) {
+		printf("Error: tiles of %i x %i are narrower than the halo of mask size %i.\n", bx, by, nm);
+		exit(-1);
+	}
+	if (ntx != sched->ntx || nty != sched->nty) {
+		printf("Error: %i x %i tiles do not match the scheduler's %i x %i.\n", ntx, nty, sched->ntx, sched->nty);
+		exit(-1);
+	}
+
+	sweep->nx = nx;
+	sweep->ny = ny;
+	sweep->nm = nm;
+	sweep->bx = bx;
+	sweep->by = by;
+	sweep->ntx = ntx;
+	sweep->steps = 1;
+	sweep->mask_lap = NULL;
+	sweep->D = 0.;
+	sweep->dt = 0.;
+}
+
+void ws_initial_conditions(struct Scheduler* sched, fp_t** conc,
+                           const int nx, const int ny, const int nm, const int bx, const int by)
+{
+	struct Sweep sweep;
+
+	make_sweep(&sweep, sched, nx, ny, nm, bx, by);
+	sweep.field[0] = conc;
+	sweep.field[1] = conc;
+
+	ws_run(sched, initial_task, &sweep, 1);
+}
+
+void ws_march(struct Scheduler* sched, fp_t*** conc_old, fp_t*** conc_new, fp_t** mask_lap,
+              const int nx, const int ny, const int nm, const int bx, const int by,
+              const fp_t D, const fp_t dt, const int steps)
+{
+	struct Sweep sweep;
+
+	make_sweep(&sweep, sched, nx, ny, nm, bx, by);
+	sweep.field[0] = *conc_old;
+	sweep.field[1] = *conc_new;
+	sweep.mask_lap = mask_lap;
+	sweep.steps = steps;
+	sweep.D = D;
+	sweep.dt = dt;
+
+	ws_run(sched, march_task, &sweep, steps);
+
+	/* after an odd number of steps the newest field is in conc_new */
+	if (steps % 2 == 1)
+		swap_pointers(conc_old, conc_new);
+}
@@ -0,0 +1,206 @@
+/**********************************************************************************
+ HiPerC: High Performance Computing Strategies for Boundary Value Problems
+ Written by Trevor Keller and available from https://github.com/usnistgov/hiperc
+ **********************************************************************************/
+
+/**
+ \file  ws_main.c
+ \brief Work-stealing implementation of semi-infinite diffusion equation
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "boundaries.h"
+#include "counters.h"
+#include "mesh.h"
+#include "numerics.h"
+#include "output.h"
+#include "roofline.h"
+#include "sampling.h"
+#include "timer.h"
+#include "trace.h"
+#include "ws.h"
+
+/**
+ \brief Run simulation on a pool of work-stealing threads using input parameters specified on the command line
+
+ Program will write a series of PNG image files to visualize scalar composition
+ field, plus a final CSV raw data file and CSV runtime log tabulating the
+ iteration counter (\a iter), elapsed simulation time (\a sim_time), error
+ relative to analytical solution (\a wrss), time spent marching tiles
+ (\a conv_time), time spent updating fields (\a step_time, zero since the
+ update is fused into each tile), time spent writing to disk (\a IO_time),
+ time spent generating analytical values (\a soln_time), total elapsed
+ (\a run_time), the sampling, roofline, and counter columns of the serial
+ program, the fraction of tiles swept (\a active, always 1), and the tasks
+ stolen so far (\a steals). Between checkpoints the \a bx by \a by tiles
+ march as far ahead as their neighbors allow, see struct Scheduler; the
+ optional key \a wt sets the number of workers.
+*/
+int main(int argc, char* argv[])
+{
+	FILE * output;
+
+	/* declare default mesh size and resolution */
+	fp_t **conc_old, **conc_new, **conc_lap, **mask_lap;
+	struct Scheduler sched;
+	int bx=32, by=32, nx=512, ny=512, nm=3, code=53;
+	fp_t dx=0.5, dy=0.5, h;
+
+	/* declare default materials and numerical parameters */
+	fp_t D=0.00625, linStab=0.1, dt=1., elapsed=0., rss=0.;
+	int step=0, steps=100000, checks=10000;
+	struct Stopwatch watch = {0., 0., 0., 0.};
+	struct Roofline roof;
+	int stream=0, counters=0, events=0, interval=1, randomized=0, workers=0;
+	struct Sampler sampler;
+	unsigned long long trace_start;
+	long long start_events[NUM_EVENTS];
+
+	StartTimer();
+
+	param_parser(argc, argv, &bx, &by, &checks, &code, &D, &dx, &dy, &linStab, &nm, &nx, &ny, &steps);
+	param_optional_int(argc, argv, "pc", &counters);
+	open_counters(counters);
+	param_optional_int(argc, argv, "tr", &events);
+	open_trace(events);
+	param_optional_int(argc, argv, "ts", &interval);
+	param_optional_int(argc, argv, "rs", &randomized);
+	init_sampler(&sampler, interval, randomized);
+	param_optional_int(argc, argv, "wt", &workers);
+	if (workers < 1)
+		workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers < 1)
+		workers = 1;
+
+	h = (dx > dy) ? dy : dx;
+	dt = (linStab * h * h) / (4.0 * D);
+
+	/* initialize memory */
+	make_arrays(&conc_old, &conc_new, &conc_lap, &mask_lap, nx, ny, nm);
+	set_mask(dx, dy, code, mask_lap, nm);
+	roofline_model(mask_lap, nx, ny, nm, &roof);
+	param_optional_int(argc, argv, "st", &stream);
+	if (stream > 0)
+		roof.peak_bw = stream_triad(1000000 * stream);
+	make_scheduler(&sched, workers, (nx - 2 * (nm/2) + bx - 1) / bx, (ny - 2 * (nm/2) + by - 1) / by);
+
+	print_progress(0, steps);
+
+	/* each worker first touches the tiles it will march */
+	timer_push("initial conditions");
+	ws_initial_conditions(&sched, conc_old, nx, ny, nm, bx, by);
+	timer_pop();
+
+	/* prepare to log comparison to analytical solution */
+	timer_push("runlog");
+	output = fopen("runlog.csv", "w");
+	if (output == NULL) {
+		printf("Error: unable to %s for output. Check permissions.\n", "runlog.csv");
+		exit(-1);
+	}
+	watch.file += timer_pop();
+
+	fprintf(output, "iter,sim_time,wrss,conv_time,step_time,IO_time,soln_time,run_time" SAMPLING_HEADER ROOFLINE_HEADER COUNTERS_HEADER ",active,steals\n");
+	estimate_stopwatch(&sampler, &watch);
+	trace_start = trace_begin();
+	fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f", step, elapsed, rss,
+			watch.conv, watch.step, watch.file, watch.soln, GetTimer());
+	print_sampling(output, &sampler);
+	print_roofline(output, &roof, &watch, step);
+	print_counters(output, &watch);
+	fprintf(output, ",%f,%li\n", 1., atomic_load(&sched.steals));
+	fflush(output);
+	trace_end("runlog", -1, trace_start);
+
+	/* write initial condition data */
+	timer_push("write_png");
+	trace_start = trace_begin();
+	write_png(conc_old, nx, ny, 0);
+	trace_end("write_png", -1, trace_start);
+	watch.file += timer_pop();
+
+	/* do the work */
+	for (step = 1; step < steps+1; step++) {
+		/* === Start Architecture-Specific Kernel === */
+		/* march to the next checkpoint as one dependency graph */
+		const int next = (step + checks - 1) / checks * checks;
+		const int last = (next < steps) ? next : steps;
+		const int span = last - step + 1;
+		double seconds;
+
+		read_counters(start_events);
+		timer_push("boundaries");
+		trace_start = trace_begin();
+		apply_boundary_conditions(conc_old, nx, ny, nm);
+		trace_end("boundaries", -1, trace_start);
+		timer_pop();
+		accumulate_counters(watch.events[PHASE_BC], start_events);
+
+		read_counters(start_events);
+		timer_push("march");
+		ws_march(&sched, &conc_old, &conc_new, mask_lap, nx, ny, nm, bx, by, D, dt, span);
+		seconds = timer_pop();
+		accumulate_counters(watch.events[PHASE_CONV], start_events);
+
+		/* steps overlap across tiles, so each is credited the mean */
+		for (int s = 0; s < span; s++) {
+			sample_step(&sampler);
+			record_sample(&sampler, SAMPLE_CONV, seconds / span);
+		}
+
+		elapsed += span * dt;
+		for (; step < last; step++)
+			print_progress(step, steps);
+		print_progress(step, steps);
+		/* === Finish Architecture-Specific Kernel === */
+
+		if (step % checks == 0) {
+			timer_push("write_png");
+			trace_start = trace_begin();
+			write_png(conc_old, nx, ny, step);
+			trace_end("write_png", -1, trace_start);
+			watch.file += timer_pop();
+
+			read_counters(start_events);
+			timer_push("check_solution");
+			trace_start = trace_begin();
+			check_solution(conc_old, conc_lap, nx, ny, dx, dy, nm, elapsed, D, &rss);
+			trace_end("check_solution", -1, trace_start);
+			watch.soln += timer_pop();
+			accumulate_counters(watch.events[PHASE_SOLN], start_events);
+
+			estimate_stopwatch(&sampler, &watch);
+			trace_start = trace_begin();
+			fprintf(output, "%i,%f,%f,%f,%f,%f,%f,%f", step, elapsed, rss,
+					watch.conv, watch.step, watch.file, watch.soln, GetTimer());
+			print_sampling(output, &sampler);
+			print_roofline(output, &roof, &watch, step);
+			print_counters(output, &watch);
+			fprintf(output, ",%f,%li\n", 1., atomic_load(&sched.steals));
+			fflush(output);
+			trace_end("runlog", -1, trace_start);
+		}
+	}
+
+	trace_start = trace_begin();
+	write_csv(conc_old, nx, ny, dx, dy, steps);
+	trace_end("write_csv", -1, trace_start);
+	estimate_stopwatch(&sampler, &watch);
+	summarize_roofline(&roof, &watch, steps);
+	printf("Work stealing: %i workers, %i tiles, %li tasks stolen: wrss %g at sim_time %g in %f s\n",
+	       sched.nthreads, sched.ntiles, atomic_load(&sched.steals), rss, elapsed, GetTimer());
+	timer_report(stdout);
+
+	/* clean up */
+	fclose(output);
+	close_counters();
+	write_trace("trace.json");
+	close_trace();
+	free_scheduler(&sched);
+	free_arrays(conc_old, conc_new, conc_lap, mask_lap);
+
+	return 0;
+}
@@ -14,6 +14,7 @@
 /** \endcond */
 
 #include "type.h"
+#include "energy.h"
 
 /**
  \brief Container for pointers to arrays on the GPU
@@ -46,7 +47,8 @@ void device_boundaries(fp_t* conc,
 /**
    \brief Compute interior Laplacian on device
 */
-void device_laplacian(fp_t* conc_old, fp_t* conc_lap, const fp_t kappa,
+void device_laplacian(fp_t* conc_old, fp_t* conc_lap,
+					  const struct FreeEnergy* fe, const fp_t kappa,
 					  const int nx, const int ny, const int nm,
 					  const int bx, const int by);
 
@@ -25,19 +25,8 @@ extern "C" {
 
 __constant__ fp_t d_mask[MAX_MASK_W * MAX_MASK_H];
 
-__device__ fp_t dfdc(const fp_t C)
-{
-	const fp_t Ca  = 0.3;
-	const fp_t Cb  = 0.7;
-	const fp_t rho = 5.0;
-
-	const fp_t A = C - Ca;
-	const fp_t B = Cb - C;
-	return 2.0 * rho * A * B * (Ca + Cb - 2.0 * C);
-}
-
-
-__global__ void convolution_kernel(fp_t* d_conc_old, fp_t* d_conc_lap, const fp_t kappa,
+__global__ void convolution_kernel(fp_t* d_conc_old, fp_t* d_conc_lap,
+                                   const struct FreeEnergy fe, const fp_t kappa,
                                    const int nx, const int ny, const int nm)
 {
 	int dst_x, dst_y, dst_nx, dst_ny;
@@ -86,7 +75,7 @@ __global__ void convolution_kernel(fp_t* d_conc_old, fp_t* d_conc_lap, const fp_
 		/* record value */
         /* Note: tile is centered on [til_nx*(til_y+nm/2) + (til_x+nm/2)], NOT [til_nx*til_y + til_x] */
 		if (dst_y < ny && dst_x < nx) {
-          d_conc_lap[nx * dst_y + dst_x] = dfdc(d_conc_tile[til_nx * (til_y+nm/2) + (til_x+nm/2)])
+          d_conc_lap[nx * dst_y + dst_x] = energy_derivative(&fe, d_conc_tile[til_nx * (til_y+nm/2) + (til_x+nm/2)])
                                          - kappa * value;
 		}
 	}
@@ -190,9 +179,10 @@ void device_boundaries(fp_t* conc,
 	);
 }
 
-void device_laplacian(fp_t* conc_old, fp_t* conc_lap, const fp_t kappa,
-                        const int nx, const int ny, const int nm,
-                        const int bx, const int by)
+void device_laplacian(fp_t* conc_old, fp_t* conc_lap,
+                      const struct FreeEnergy* fe, const fp_t kappa,
+                      const int nx, const int ny, const int nm,
+                      const int bx, const int by)
 {
 	/* divide matrices into blocks of bx * by threads */
 	dim3 tile_size(bx, by, 1);
@@ -202,7 +192,7 @@ void device_laplacian(fp_t* conc_old, fp_t* conc_lap, const fp_t kappa,
 	size_t buf_size = (tile_size.x + nm) * (tile_size.y + nm) * sizeof(fp_t);
 
 	convolution_kernel<<<num_tiles,tile_size,buf_size>>> (
-    	conc_old, conc_lap, kappa, nx, ny, nm
+    	conc_old, conc_lap, *fe, kappa, nx, ny, nm
 	);
 }
 
@@ -47,6 +47,7 @@ __global__ void boundary_kernel(fp_t* conc,
 */
 __global__ void convolution_kernel(fp_t* conc_old,
                                    fp_t* conc_lap,
+                                   const struct FreeEnergy fe,
                                    const fp_t kappa,
                                    const int nx,
                                    const int ny,
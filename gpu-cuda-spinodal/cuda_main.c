@@ -38,12 +38,18 @@ int main(int argc, char* argv[])
 
 	/* declare default materials and numerical parameters */
 	fp_t M=5.0, kappa=2.0, linStab=0.25, elapsed=0., energy=0.;
+	fp_t Ca=0.3, Cb=0.7, rho=5.0;
+	struct FreeEnergy fe;
 	int step=0, steps=5000000, checks=100000;
 	struct Stopwatch watch = {0., 0., 0., 0.};
 
 	StartTimer();
 
 	param_parser(argc, argv, &bx, &by, &checks, &code, &M, &kappa, &linStab, &nm, &nx, &ny, &steps);
+	param_optional_fp(argc, argv, "ca", &Ca);
+	param_optional_fp(argc, argv, "cb", &Cb);
+	param_optional_fp(argc, argv, "rh", &rho);
+	double_well_energy(&fe, Ca, Cb, rho);
 
 	const fp_t dt = linStab / (24.0 * M * kappa);
 
@@ -74,7 +80,7 @@ int main(int argc, char* argv[])
 	watch.file = GetTimer() - start_time;
 
 	fprintf(output, "iter,sim_time,energy,conv_time,step_time,IO_time,run_time\n");
-	fprintf(output, "%i,%f,%f,%f,%f,%f,%f\n", step, elapsed, nx*dx * ny*dy * chem_energy(0.5),
+	fprintf(output, "%i,%f,%f,%f,%f,%f,%f\n", step, elapsed, nx*dx * ny*dy * energy_density(&fe, 0.5),
 	        watch.conv, watch.step, watch.file, GetTimer());
 	fflush(output);
 
@@ -86,7 +92,7 @@ int main(int argc, char* argv[])
 		device_boundaries(dev.conc_old, nx, ny, nm, bx, by);
 
 		start_time = GetTimer();
-		device_laplacian(dev.conc_old, dev.conc_lap, kappa, nx, ny, nm, bx, by);
+		device_laplacian(dev.conc_old, dev.conc_lap, &fe, kappa, nx, ny, nm, bx, by);
 		watch.conv += GetTimer() - start_time;
 
 		device_boundaries(dev.conc_lap, nx, ny, nm, bx, by);
@@ -110,7 +116,7 @@ int main(int argc, char* argv[])
 			read_out_result(conc_new, dev.conc_old, nx, ny);
 			watch.file += GetTimer() - start_time;
 
-			free_energy(conc_new, conc_lap, dx, dy, nx, ny, nm, kappa, &energy);
+			free_energy(conc_new, dx, dy, nx, ny, nm, &fe, kappa, &energy);
 
 			start_time = GetTimer();
 			write_png(conc_new, nx, ny, dt * step);